@@ -2,32 +2,17 @@
 The implementation of AVL Tree, letting the tree maintain balanced
 */
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <functional>
 #include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
-template<class KEY, class OTHER>
-struct set {
-    KEY key;
-    OTHER other;
-};
-
-
-// Dynamic Search Table
-template<class Key, class Other>
-class dynamicSearchTable {
-public:
-    // finding elements of x
-    virtual set<Key, Other> *find(const Key &x) const = 0;
-
-    // insert element, maintaining the order
-    virtual void insert(const set<Key, Other> &x) = 0;
-
-    // remove an element, maintaining the order
-    virtual void remove(const Key &x) = 0;
-
-    virtual ~dynamicSearchTable() {}
-};
-
+#include "dynamicSearchTable.hpp"
 
 template<class KEY, class OTHER>
 class AVLTree : public dynamicSearchTable<KEY, OTHER> {
@@ -46,6 +31,12 @@ class AVLTree : public dynamicSearchTable<KEY, OTHER> {
 private:
     AVLNode *root;
 
+    // an AVL tree of height h has at least fib(h + 2) - 1 nodes, 96 levels is far more than the memory allows
+    static const int MAX_HEIGHT = 96;
+
+    // subtrees at most this high are not worth a thread in the set operations
+    static const int PARALLEL_CUTOFF = 12;
+
 private:
     // Tool functions
 
@@ -64,17 +55,18 @@ private:
 
     /**
          * @brief insert the new element in the tree, adjusting structures when necessary
+         * (the recursive version, kept as the reference for the iterative insert)
          * 
          * @param x 
          * @param root_ 
          */
-    void insert(const set<KEY, OTHER> &x, AVLNode *&root_) {
+    void insertRecursive(const set<KEY, OTHER> &x, AVLNode *&root_) {
         if (root_ == nullptr) {
             // insert in an empty tree
             root_ = new AVLNode(x, nullptr, nullptr);
         } else if (x.key < root_->data.key) {
             // insert in the left tree
-            insert(x, root_->left);
+            insertRecursive(x, root_->left);
 
             // judging whether is is out of balanced
             if (height(root_->left) - height(root_->right) == 2) {
@@ -87,7 +79,7 @@ private:
             }
         } else if (x.key > root_->data.key) {
             // insert in the right tree
-            insert(x, root_->right);
+            insertRecursive(x, root_->right);
 
             // judging whether it is out of balanced
             if (height(root_->right) - height(root_->left) == 2) {
@@ -107,13 +99,14 @@ private:
 
     /**
          * @brief Remove the element with the value x
+         * (the recursive version, kept as the reference for the iterative remove)
          * 
          * @param x key value
          * @param root_ current root node
          * @return true if the tree is balanced after the deletion
          * @return false 
          */
-    bool remove(const KEY &x, AVLNode *&root_) {
+    bool removeRecursive(const KEY &x, AVLNode *&root_) {
         if (root_ == nullptr) {
             return true;
         }
@@ -142,7 +135,7 @@ private:
 
                 root_->data = tmp->data;
                 // then remove the leaf node (tmp)
-                if (remove(tmp->data.key, root_->right)) {
+                if (removeRecursive(tmp->data.key, root_->right)) {
                     return true;
                 }
 
@@ -152,14 +145,14 @@ private:
 
         if (x < (root_->data).key) {
             // delete on the left subtree
-            if (remove(x, root_->left)) {
+            if (removeRecursive(x, root_->left)) {
                 return true;
             } else {
                 return adjust(root_, 0);
             }
         } else {
             // delete on the right subtree
-            if (remove(x, root_->right)) {
+            if (removeRecursive(x, root_->right)) {
                 return true;
             } else {
                 return adjust(root_, 1);
@@ -182,6 +175,19 @@ private:
         delete root_;
     }
 
+    /**
+         * @brief Deep copy of a subtree, the heights are copied as they are
+         * 
+         * @param root_ 
+         * @return AVLNode* 
+         */
+    AVLNode *copy(AVLNode *root_) const {
+        if (root_ == nullptr) {
+            return nullptr;
+        }
+        return new AVLNode(root_->data, copy(root_->left), copy(root_->right), root_->height);
+    }
+
     /**
          * @brief Return the height of the tree
          * 
@@ -212,6 +218,7 @@ private:
         // update height
         updateHeight(danger);
         updateHeight(t1);
+        danger = t1;
     }
 
     /**
@@ -230,6 +237,7 @@ private:
         // update height
         updateHeight(danger);
         updateHeight(t1);
+        danger = t1;
     }
 
     /**
@@ -303,6 +311,324 @@ private:
         }
     }
 
+    /**
+         * @brief Restore the balance of t, whose subtrees differ in height by at most 2
+         * and have correct heights, and update the height of t
+         * 
+         * @param t the slot holding the subtree root, rewritten by the rotations
+         */
+    void balance(AVLNode **t) {
+        AVLNode *node = *t;
+        int lh = height(node->left), rh = height(node->right);
+        if (lh - rh == 2) {
+            if (height(node->left->left) >= height(node->left->right)) {
+                LL(*t);
+            } else {
+                LR(*t);
+            }
+        } else if (rh - lh == 2) {
+            if (height(node->right->right) >= height(node->right->left)) {
+                RR(*t);
+            } else {
+                RL(*t);
+            }
+        } else {
+            node->height = (lh > rh ? lh : rh) + 1;
+        }
+    }
+
+    /**
+         * @brief Walk back up the path, rebalancing, and stop as soon as a subtree
+         * keeps the height it had before the update: nothing above it can change
+         * 
+         * @param path the slots from the root down to the changed subtree
+         * @param top the number of slots in path
+         */
+    void rebalancePath(AVLNode **path[], int top) {
+        while (top > 0) {
+            AVLNode **t = path[--top];
+            int old_height = (*t)->height;
+            balance(t);
+            if ((*t)->height == old_height) {
+                return;
+            }
+        }
+    }
+
+    // --- Join-based set operations (Blelloch, Ferizovic and Sun, 2016) ---
+
+    /**
+         * @brief Make k the root of left and right, with the height updated
+         */
+    AVLNode *makeNode(AVLNode *left, AVLNode *k, AVLNode *right) {
+        k->left = left;
+        k->right = right;
+        updateHeight(k);
+        return k;
+    }
+
+    /**
+         * @brief join when left is more than one level higher than right: go down the right
+         * spine of left to a subtree as high as right, hang it there and rebalance on the way back
+         */
+    AVLNode *joinRight(AVLNode *left, AVLNode *k, AVLNode *right) {
+        AVLNode *l = left->left, *c = left->right;
+        if (height(c) <= height(right) + 1) {
+            AVLNode *t = makeNode(c, k, right);
+            if (height(t) <= height(l) + 1) {
+                return makeNode(l, left, t);
+            }
+            LL(t);
+            AVLNode *result = makeNode(l, left, t);
+            RR(result);
+            return result;
+        }
+        AVLNode *t = joinRight(c, k, right);
+        AVLNode *result = makeNode(l, left, t);
+        if (height(t) > height(l) + 1) {
+            RR(result);
+        }
+        return result;
+    }
+
+    // the mirror image of joinRight
+    AVLNode *joinLeft(AVLNode *left, AVLNode *k, AVLNode *right) {
+        AVLNode *c = right->left, *r = right->right;
+        if (height(c) <= height(left) + 1) {
+            AVLNode *t = makeNode(left, k, c);
+            if (height(t) <= height(r) + 1) {
+                return makeNode(t, right, r);
+            }
+            RR(t);
+            AVLNode *result = makeNode(t, right, r);
+            LL(result);
+            return result;
+        }
+        AVLNode *t = joinLeft(left, k, c);
+        AVLNode *result = makeNode(t, right, r);
+        if (height(t) > height(r) + 1) {
+            LL(result);
+        }
+        return result;
+    }
+
+    /**
+         * @brief The tree of left, k and right, where all keys in left < k < all keys in right.
+         * O(|height(left) - height(right)| + 1)
+         */
+    AVLNode *joinNodes(AVLNode *left, AVLNode *k, AVLNode *right) {
+        if (height(left) > height(right) + 1) {
+            return joinRight(left, k, right);
+        }
+        if (height(right) > height(left) + 1) {
+            return joinLeft(left, k, right);
+        }
+        return makeNode(left, k, right);
+    }
+
+    /**
+         * @brief Split t into the keys < key and the keys > key, O(log n)
+         * 
+         * @return AVLNode* the node with the key, detached, or nullptr
+         */
+    AVLNode *splitNodes(AVLNode *t, const KEY &key, AVLNode *&left, AVLNode *&right) {
+        if (t == nullptr) {
+            left = right = nullptr;
+            return nullptr;
+        }
+        if (key < t->data.key) {
+            AVLNode *middle = splitNodes(t->left, key, left, right);
+            right = joinNodes(right, t, t->right);
+            return middle;
+        }
+        if (t->data.key < key) {
+            AVLNode *middle = splitNodes(t->right, key, left, right);
+            left = joinNodes(t->left, t, left);
+            return middle;
+        }
+        left = t->left;
+        right = t->right;
+        t->left = t->right = nullptr;
+        t->height = 1;
+        return t;
+    }
+
+    // remove the last node of t, which is returned in last
+    AVLNode *splitLast(AVLNode *t, AVLNode *&last) {
+        if (t->right == nullptr) {
+            last = t;
+            return t->left;
+        }
+        AVLNode *rest = splitLast(t->right, last);
+        return joinNodes(t->left, t, rest);
+    }
+
+    // join without a middle key
+    AVLNode *join2(AVLNode *left, AVLNode *right) {
+        if (left == nullptr) {
+            return right;
+        }
+        AVLNode *last;
+        AVLNode *rest = splitLast(left, last);
+        return joinNodes(rest, last, right);
+    }
+
+    // t ∪ {x} for a detached leaf x, t wins: the descent of insert, cheaper than splitting down to the leaves
+    AVLNode *insertNode(AVLNode *t, AVLNode *x) {
+        AVLNode **path[MAX_HEIGHT];
+        int top = 0;
+        AVLNode **p = &t;
+        while (*p != nullptr) {
+            path[top++] = p;
+            if (x->data.key < (*p)->data.key) {
+                p = &(*p)->left;
+            } else if ((*p)->data.key < x->data.key) {
+                p = &(*p)->right;
+            } else {
+                delete x;
+                return t;
+            }
+        }
+        *p = x;
+        rebalancePath(path, top);
+        return t;
+    }
+
+    // tree without the key x, by the iterative descent of remove
+    AVLNode *removeKey(AVLNode *tree, const KEY &x) {
+        AVLNode **path[MAX_HEIGHT];
+        int top = 0;
+        AVLNode **t = &tree;
+        while (*t != nullptr && (*t)->data.key != x) {
+            path[top++] = t;
+            if (x < (*t)->data.key) {
+                t = &(*t)->left;
+            } else {
+                t = &(*t)->right;
+            }
+        }
+        if (*t == nullptr) {
+            return tree;
+        }
+
+        AVLNode *target = *t;
+        if (target->left != nullptr && target->right != nullptr) {
+            // replace the data with the successor, then unlink the successor instead
+            path[top++] = t;
+            AVLNode **s = &target->right;
+            while ((*s)->left != nullptr) {
+                path[top++] = s;
+                s = &(*s)->left;
+            }
+            target->data = (*s)->data;
+            t = s;
+        }
+
+        AVLNode *old_node = *t;
+        *t = old_node->left != nullptr ? old_node->left : old_node->right;
+        delete old_node;
+        rebalancePath(path, top);
+        return tree;
+    }
+
+    /**
+         * @brief Run the two branches of a set operation, the first one in a new thread while
+         * spawn_depth > 0 and the subtree is large enough to pay for the thread
+         */
+    template<class First, class Second>
+    void forkJoin(int spawn_depth, AVLNode *t, First &&first, Second &&second) {
+        if (spawn_depth > 0 && height(t) > PARALLEL_CUTOFF) {
+            std::thread worker(std::ref(first));
+            second();
+            worker.join();
+        } else {
+            first();
+            second();
+        }
+    }
+
+    // a ∪ b, a wins for the keys in both, both trees are consumed
+    AVLNode *unionNodes(AVLNode *a, AVLNode *b, int spawn_depth) {
+        if (a == nullptr) return b;
+        if (b == nullptr) return a;
+        if (b->height == 1) return insertNode(a, b);
+        AVLNode *b_left, *b_right;
+        AVLNode *duplicate = splitNodes(b, a->data.key, b_left, b_right);
+        delete duplicate;
+
+        AVLNode *left, *right, *a_left = a->left, *a_right = a->right;
+        forkJoin(
+                spawn_depth, a, [&]() { left = unionNodes(a_left, b_left, spawn_depth - 1); },
+                [&]() { right = unionNodes(a_right, b_right, spawn_depth - 1); });
+        return joinNodes(left, a, right);
+    }
+
+    // a ∩ b with the elements of a, both trees are consumed
+    AVLNode *intersectionNodes(AVLNode *a, AVLNode *b, int spawn_depth) {
+        if (a == nullptr || b == nullptr) {
+            makeEmpty(a);
+            makeEmpty(b);
+            return nullptr;
+        }
+        AVLNode *b_left, *b_right;
+        AVLNode *duplicate = splitNodes(b, a->data.key, b_left, b_right);
+
+        AVLNode *left, *right, *a_left = a->left, *a_right = a->right;
+        forkJoin(
+                spawn_depth, a, [&]() { left = intersectionNodes(a_left, b_left, spawn_depth - 1); },
+                [&]() { right = intersectionNodes(a_right, b_right, spawn_depth - 1); });
+        if (duplicate != nullptr) {
+            delete duplicate;
+            return joinNodes(left, a, right);
+        }
+        delete a;
+        return join2(left, right);
+    }
+
+    // a - b, both trees are consumed
+    AVLNode *differenceNodes(AVLNode *a, AVLNode *b, int spawn_depth) {
+        if (a == nullptr || b == nullptr) {
+            makeEmpty(b);
+            return a;
+        }
+        if (b->height == 1) {
+            a = removeKey(a, b->data.key);
+            delete b;
+            return a;
+        }
+        AVLNode *a_left, *a_right;
+        AVLNode *duplicate = splitNodes(a, b->data.key, a_left, a_right);
+        delete duplicate;
+
+        AVLNode *left, *right, *b_left = b->left, *b_right = b->right;
+        forkJoin(
+                spawn_depth, b, [&]() { left = differenceNodes(a_left, b_left, spawn_depth - 1); },
+                [&]() { right = differenceNodes(a_right, b_right, spawn_depth - 1); });
+        delete b;
+        return join2(left, right);
+    }
+
+    // the real height of t, or -1 if a stored height is wrong or two sibling heights differ by more than 1
+    int checkedHeight(AVLNode *t) const {
+        if (t == nullptr) {
+            return 0;
+        }
+        int left = checkedHeight(t->left), right = checkedHeight(t->right);
+        if (left < 0 || right < 0 || left - right > 1 || right - left > 1 || t->height != std::max(left, right) + 1) {
+            return -1;
+        }
+        return t->height;
+    }
+
+    // spawning 4 tasks per thread leaves room to balance uneven branches
+    static int spawnDepth(size_t thread_num) {
+        int depth = 0;
+        while ((size_t(1) << depth) < thread_num) {
+            ++depth;
+        }
+        return thread_num > 1 ? depth + 2 : 0;
+    }
+
 public:
     /**
          * @brief Construct a new AVLTree object
@@ -312,6 +638,18 @@ public:
         root = nullptr;
     }
 
+    AVLTree(const AVLTree &other) {
+        root = copy(other.root);
+    }
+
+    AVLTree &operator=(const AVLTree &other) {
+        if (this != &other) {
+            makeEmpty(root);
+            root = copy(other.root);
+        }
+        return *this;
+    }
+
     // destructor
     ~AVLTree() {
         makeEmpty(root);
@@ -341,17 +679,259 @@ public:
         }
     }
 
+    /**
+         * @brief Insert x without recursion: the slots on the search path are kept
+         * in a fixed-size stack and rebalanced bottom-up, stopping once the height
+         * of a subtree does not change. Repetition makes no operations.
+         * 
+         * @param x 
+         */
     void insert(const set<KEY, OTHER> &x) {
-        insert(x, root);
+        AVLNode **path[MAX_HEIGHT];
+        int top = 0;
+        AVLNode **t = &root;
+        while (*t != nullptr) {
+            path[top++] = t;
+            if (x.key < (*t)->data.key) {
+                t = &(*t)->left;
+            } else if ((*t)->data.key < x.key) {
+                t = &(*t)->right;
+            } else {
+                return;
+            }
+        }
+        *t = new AVLNode(x, nullptr, nullptr);
+        rebalancePath(path, top);
     }
 
+    /**
+         * @brief Remove the element with the key x without recursion, the same
+         * path stack and early stop as insert
+         * 
+         * @param x 
+         */
     void remove(const KEY &x) {
-        remove(x, root);
+        root = removeKey(root, x);
+    }
+
+    /**
+         * @brief The recursive insert, kept to compare with the iterative one
+         * 
+         * @param x 
+         */
+    void insertRecursive(const set<KEY, OTHER> &x) {
+        insertRecursive(x, root);
+    }
+
+    /**
+         * @brief The recursive remove, kept to compare with the iterative one
+         * 
+         * @param x 
+         */
+    void removeRecursive(const KEY &x) {
+        removeRecursive(x, root);
+    }
+
+    /**
+         * @brief The number of elements, O(n)
+         * 
+         * @return size_t 
+         */
+    size_t size() const {
+        size_t count = 0;
+        AVLNode *stack[MAX_HEIGHT];
+        int top = 0;
+        if (root != nullptr) stack[top++] = root;
+        while (top > 0) {
+            AVLNode *t = stack[--top];
+            ++count;
+            if (t->left != nullptr) stack[top++] = t->left;
+            if (t->right != nullptr) stack[top++] = t->right;
+        }
+        return count;
+    }
+
+    /**
+         * @brief Move the elements with keys < key to left and the others to right,
+         * this tree becomes empty. O(log n)
+         * 
+         * @return true if key was in the tree, it is in right then
+         */
+    bool split(const KEY &key, AVLTree &left, AVLTree &right) {
+        AVLNode *t = root;
+        root = nullptr;
+        left.makeEmpty(left.root);
+        right.makeEmpty(right.root);
+        AVLNode *l, *r;
+        AVLNode *middle = splitNodes(t, key, l, r);
+        left.root = l;
+        right.root = middle != nullptr ? joinNodes(nullptr, middle, r) : r;
+        return middle != nullptr;
+    }
+
+    /**
+         * @brief This tree becomes left ∪ {x} ∪ right, which requires
+         * all keys in left < x.key < all keys in right. left and right become empty.
+         * O(|height(left) - height(right)| + 1)
+         */
+    void join(AVLTree &left, const set<KEY, OTHER> &x, AVLTree &right) {
+        AVLNode *l = left.root, *r = right.root;
+        left.root = right.root = nullptr;
+        makeEmpty(root);
+        root = joinNodes(l, new AVLNode(x, nullptr, nullptr), r);
+    }
+
+    /**
+         * @brief this = this ∪ other, this wins for the keys in both, other becomes empty (unless it is this).
+         * O(m log(n / m + 1)) work for sizes m <= n, the recursive branches run in parallel
+         * 
+         * @param thread_num the number of threads to use
+         */
+    void unionWith(AVLTree &other, size_t thread_num = 1) {
+        if (&other == this) {
+            return;
+        }
+        root = unionNodes(root, other.root, spawnDepth(thread_num));
+        other.root = nullptr;
+    }
+
+    /**
+         * @brief this = this ∩ other, other becomes empty (unless it is this)
+         */
+    void intersectWith(AVLTree &other, size_t thread_num = 1) {
+        if (&other == this) {
+            return;
+        }
+        root = intersectionNodes(root, other.root, spawnDepth(thread_num));
+        other.root = nullptr;
+    }
+
+    /**
+         * @brief this = this - other, other becomes empty (this too, if it is other)
+         */
+    void differenceWith(AVLTree &other, size_t thread_num = 1) {
+        if (&other == this) {
+            makeEmpty(root);
+            root = nullptr;
+            return;
+        }
+        root = differenceNodes(root, other.root, spawnDepth(thread_num));
+        other.root = nullptr;
+    }
+
+    /**
+         * @brief All the elements in the order of the keys, O(n)
+         * 
+         * @return std::vector<set<KEY, OTHER>> 
+         */
+    std::vector<set<KEY, OTHER>> elements() const {
+        std::vector<set<KEY, OTHER>> result;
+        AVLNode *stack[MAX_HEIGHT];
+        int top = 0;
+        AVLNode *t = root;
+        while (t != nullptr || top > 0) {
+            while (t != nullptr) {
+                stack[top++] = t;
+                t = t->left;
+            }
+            t = stack[--top];
+            result.push_back(t->data);
+            t = t->right;
+        }
+        return result;
+    }
+
+    /**
+         * @brief Check the AVL invariant: the keys are strictly increasing in order, every
+         * stored height is right and the heights of two siblings differ by at most 1. O(n)
+         */
+    bool balanced() const {
+        if (checkedHeight(root) < 0) {
+            return false;
+        }
+        std::vector<set<KEY, OTHER>> all = elements();
+        for (size_t i = 1; i < all.size(); ++i) {
+            if (!(all[i - 1].key < all[i].key)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+         * @brief Return the height of the whole tree
+         * 
+         * @return int 
+         */
+    int height() const {
+        return height(root);
     }
 };
 
 
-int main() {
+#ifndef BENCHMARK_NO_MAIN
+/**
+ * @brief time one set operation on copies of a and b, returns milliseconds
+ */
+template<class Operation>
+double timeSetOperation(const AVLTree<int, int> &a, const AVLTree<int, int> &b, Operation operation, size_t &result_size) {
+    AVLTree<int, int> x(a), y(b);
+    auto start = std::chrono::high_resolution_clock::now();
+    operation(x, y);
+    auto end = std::chrono::high_resolution_clock::now();
+    result_size = x.size();
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+    return elapsed.count();
+}
+
+/**
+ * @brief the same keys and payloads in the same order
+ */
+template<class KEY, class OTHER>
+bool sameElements(const std::vector<set<KEY, OTHER>> &x, const std::vector<set<KEY, OTHER>> &y) {
+    if (x.size() != y.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < x.size(); ++i) {
+        if (x[i].key != y[i].key || x[i].other != y[i].other) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Run the three set operations on copies of a and b and compare every result element by
+ * element with std::set_union, std::set_intersection and std::set_difference, which take the
+ * element of the first range for equal keys just as the tree keeps its own.
+ * The results must also keep the AVL invariant and leave the other tree empty.
+ */
+template<class KEY, class OTHER>
+bool checkSetOperations(const AVLTree<KEY, OTHER> &a, const AVLTree<KEY, OTHER> &b, size_t thread_num) {
+    typedef std::vector<set<KEY, OTHER>> elements;
+    auto byKey = [](const set<KEY, OTHER> &x, const set<KEY, OTHER> &y) { return x.key < y.key; };
+    elements a_elements = a.elements(), b_elements = b.elements(), united, shared, left;
+    std::set_union(a_elements.begin(), a_elements.end(), b_elements.begin(), b_elements.end(),
+                   std::back_inserter(united), byKey);
+    std::set_intersection(a_elements.begin(), a_elements.end(), b_elements.begin(), b_elements.end(),
+                          std::back_inserter(shared), byKey);
+    std::set_difference(a_elements.begin(), a_elements.end(), b_elements.begin(), b_elements.end(),
+                        std::back_inserter(left), byKey);
+
+    AVLTree<KEY, OTHER> x(a), y(b);
+    x.unionWith(y, thread_num);
+    bool pass = x.balanced() && y.size() == 0 && sameElements(x.elements(), united);
+    x = a;
+    y = b;
+    x.intersectWith(y, thread_num);
+    pass = pass && x.balanced() && y.size() == 0 && sameElements(x.elements(), shared);
+    x = a;
+    y = b;
+    x.differenceWith(y, thread_num);
+    return pass && x.balanced() && y.size() == 0 && sameElements(x.elements(), left);
+}
+
+int main(int argc, char *argv[]) {
     // Create an AVLTree instance
     AVLTree<int, std::string> tree;
 
@@ -402,5 +982,112 @@ int main() {
 
     std::cout << "AVL tree test completed." << std::endl;
 
+    std::cout << "\n--- Join-based set operations ---" << std::endl;
+    AVLTree<int, std::string> odd, small, left, right;
+    for (int i = 1; i < 20; i += 2) {
+        odd.insert({i, "odd"});
+    }
+    for (int i = 0; i < 6; ++i) {
+        small.insert({i, "small"});
+    }
+    odd.split(9, left, right);
+    std::cout << "split(9): " << left.size() << " + " << right.size() << " (Expected: 4 + 6), "
+              << (left.balanced() && right.balanced() && left.elements().back().key == 7 &&
+                                  right.elements().front().key == 9
+                          ? "PASS"
+                          : "FAIL")
+              << std::endl;
+    odd.join(left, {8, "eight"}, right);
+    std::cout << "join back with 8: " << odd.size() << ", height " << odd.height() << " (Expected: 11, 4), "
+              << (odd.balanced() && odd.find(8) != nullptr ? "PASS" : "FAIL") << std::endl;
+    std::cout << "set operations with {0..5} against std::set_union / intersection / difference: "
+              << (checkSetOperations(odd, small, 1) ? "PASS" : "FAIL") << std::endl;
+    AVLTree<int, std::string> copied(small);
+    odd.unionWith(small);
+    std::cout << "union with {0..5}: " << odd.size() << ", 3 -> " << odd.find(3)->other
+              << " (Expected: 14, odd)" << std::endl;
+    odd.differenceWith(copied);
+    std::cout << "minus {0..5}: " << odd.size() << " (Expected: 8)" << std::endl;
+    odd.unionWith(odd);
+    odd.intersectWith(odd);
+    std::cout << "with itself: union and intersection " << odd.size();
+    odd.differenceWith(odd);
+    std::cout << ", difference " << odd.size() << " (Expected: 8, 0)" << std::endl;
+
+    // random sets of different sizes, payloads tell which tree an element came from
+    std::mt19937 gen(2025);
+    bool random_pass = true;
+    for (size_t m : {1, 50, 5000, 20000}) {
+        AVLTree<int, int> a, b;
+        for (int i = 0; i < 20000; ++i) {
+            a.insert({int(gen() % 60000), 0});
+        }
+        for (size_t i = 0; i < m; ++i) {
+            b.insert({int(gen() % 60000), 1});
+        }
+        random_pass = random_pass && a.balanced() && b.balanced();
+        for (size_t t : {1, 4}) {
+            random_pass = random_pass && checkSetOperations(a, b, t) && checkSetOperations(b, a, t);
+        }
+    }
+    std::cout << "random sets of 20000 and 1 .. 20000 keys: " << (random_pass ? "PASS" : "FAIL") << std::endl;
+
+    // usage: AVLTree [keys of the larger set] [max threads]
+    size_t n = argc > 1 ? std::stoull(argv[1]) : 50000000;
+    size_t max_threads = argc > 2 ? std::stoull(argv[2]) : std::max<unsigned>(1, std::thread::hardware_concurrency());
+    for (size_t ratio : {1, 1000}) {
+        // b has m keys spread over the range of a, which has n
+        size_t m = std::max<size_t>(1, n / ratio);
+        std::cout << "\n--- Benchmark: sets of " << n << " and " << m << " keys ---" << std::endl;
+        for (double overlap : {0.01, 0.5, 0.99}) {
+            // b shares a key with a for the first overlap * m of its keys
+            auto keyOfB = [overlap, m, ratio](size_t i) { return int(3 * i * ratio + (i < overlap * m ? 0 : 1)); };
+            AVLTree<int, int> a, b;
+            for (size_t i = 0; i < n; ++i) {
+                a.insert({int(3 * i), 0});
+            }
+            for (size_t i = 0; i < m; ++i) {
+                b.insert({keyOfB(i), 1});
+            }
+            std::cout << "overlap " << overlap * 100 << "%:" << std::endl;
+
+            // the old way: insert (or remove) the elements of b in a one by one
+            size_t expected_union, expected_difference;
+            double insert_time = timeSetOperation(
+                    a, b, [m, &keyOfB](AVLTree<int, int> &x, AVLTree<int, int> &) {
+                        for (size_t i = 0; i < m; ++i) {
+                            x.insert({keyOfB(i), 1});
+                        }
+                    },
+                    expected_union);
+            double remove_time = timeSetOperation(
+                    a, b, [m, &keyOfB](AVLTree<int, int> &x, AVLTree<int, int> &) {
+                        for (size_t i = 0; i < m; ++i) {
+                            x.remove(keyOfB(i));
+                        }
+                    },
+                    expected_difference);
+            std::cout << "  one by one: insert " << insert_time << " ms, remove " << remove_time << " ms" << std::endl;
+
+            for (size_t t = 1; t <= max_threads; t = (t * 2 > max_threads && t != max_threads) ? max_threads : t * 2) {
+                size_t union_size, intersection_size, difference_size;
+                double union_time = timeSetOperation(
+                        a, b, [t](AVLTree<int, int> &x, AVLTree<int, int> &y) { x.unionWith(y, t); }, union_size);
+                double intersection_time = timeSetOperation(
+                        a, b, [t](AVLTree<int, int> &x, AVLTree<int, int> &y) { x.intersectWith(y, t); },
+                        intersection_size);
+                double difference_time = timeSetOperation(
+                        a, b, [t](AVLTree<int, int> &x, AVLTree<int, int> &y) { x.differenceWith(y, t); },
+                        difference_size);
+                size_t shared = size_t(std::ceil(overlap * m));
+                bool pass = union_size == expected_union && intersection_size == shared &&
+                            difference_size == expected_difference && difference_size == n - shared;
+                std::cout << "  " << t << " threads: union " << union_time << " ms, intersection "
+                          << intersection_time << " ms, difference " << difference_time << " ms "
+                          << (pass ? "PASS" : "FAIL") << std::endl;
+            }
+        }
+    }
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -9,30 +9,11 @@
  * Copyright (c) 2025 by Xiyuan Yang, All Rights Reserved.
  */
 
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 
-template<class KEY, class OTHER>
-struct set {
-    KEY key;
-    OTHER other;
-};
-
-// Dynamic Search Table
-template<class Key, class Other>
-class dynamicSearchTable {
-public:
-    // finding elements of x
-    virtual set<Key, Other> *find(const Key &x) const = 0;
-
-    // insert element, maintaining the order
-    virtual void insert(const set<Key, Other> &x) = 0;
-
-    // remove an element, maintaining the order
-    virtual void remove(const Key &x) = 0;
-
-    virtual ~dynamicSearchTable() {}
-};
+#include "dynamicSearchTable.hpp"
 
 template<class Key, class Other>
 class BST : public dynamicSearchTable<Key, Other> {
@@ -151,6 +132,19 @@ private:
         }
     }
 
+    /**
+   * @brief the height of the tree, an empty tree has height 0
+   *
+   * @param t root node
+   * @return int
+   */
+    int height(BinaryNode *t) const {
+        if (t == nullptr) {
+            return 0;
+        }
+        return std::max(height(t->left), height(t->right)) + 1;
+    }
+
 public:
     BST() {
         // create an empty tree
@@ -179,8 +173,16 @@ public:
    * @return set<Key, Other>*
    */
     set<Key, Other> *find(const Key &x) const { return find(x, root); }
+
+    /**
+   * @brief return the height of the tree
+   *
+   * @return int
+   */
+    int height() const { return height(root); }
 };
 
+#ifndef BENCHMARK_NO_MAIN
 int main() {
     // 创建一个BST实例
     BST<int, std::string> bst;
@@ -244,4 +246,5 @@ int main() {
     }
 
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,415 @@
+/*
+The implementation of a 64-ary bitmap trie, an ordered set / map of integer keys of up to 32 bits.
+Like a van Emde Boas tree it works on the bits of the key instead of comparisons: the 32 bits are cut
+into 6 levels (2 + 5 * 6 bits), every node keeps a 64-bit bitmap of its non-empty children, and the
+children are stored packed in key order, found by the popcount of the bits below. find, insert,
+remove, successor and predecessor touch at most 6 nodes whatever the number of keys.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "dynamicSearchTable.hpp"
+
+#ifndef BENCHMARK_NO_MAIN
+#include "map.hpp"
+#endif
+
+template<class KEY, class OTHER>
+class BitmapTrie : public dynamicSearchTable<KEY, OTHER> {
+    static_assert(std::is_integral<KEY>::value && sizeof(KEY) <= 4, "BitmapTrie needs an integer key of up to 32 bits");
+
+    /**
+     * @brief A node of the trie. Above the leaves, slots is a packed array of the child nodes;
+     * at the leaves (shift 0), slots is a packed array of the elements. The capacity of the array
+     * is the popcount of bits rounded up to a power of two, so it is not stored.
+     */
+    struct TrieNode {
+        uint64_t bits = 0;
+        void *slots = nullptr;
+    };
+
+    static const int LEVELS = 6;
+    static const int LEAF = LEVELS - 1;
+
+private:
+    TrieNode root;
+    size_t current_size = 0;
+
+    static int shiftOf(int level) {
+        return 30 - 6 * level;
+    }
+
+    /**
+     * @brief Map the key to an unsigned integer of the same order
+     */
+    static uint32_t encode(const KEY &x) {
+        if (std::is_signed<KEY>::value) {
+            return uint32_t(int64_t(x) + (int64_t(1) << 31));
+        }
+        return uint32_t(x);
+    }
+
+    static unsigned indexOf(uint32_t u, int level) {
+        return (u >> shiftOf(level)) & 63;
+    }
+
+    // the position of child idx in the packed array
+    static unsigned rankOf(uint64_t bits, unsigned idx) {
+        return __builtin_popcountll(bits & ((uint64_t(1) << idx) - 1));
+    }
+
+    static size_t capacityOf(size_t count) {
+        size_t capacity = 1;
+        while (capacity < count) {
+            capacity <<= 1;
+        }
+        return count == 0 ? 0 : capacity;
+    }
+
+    static TrieNode *children(const TrieNode *t) {
+        return static_cast<TrieNode *>(t->slots);
+    }
+
+    static set<KEY, OTHER> *elements(const TrieNode *t) {
+        return static_cast<set<KEY, OTHER> *>(t->slots);
+    }
+
+    /**
+     * @brief Open a slot at position rank of a packed array holding count items, growing it when full
+     */
+    template<class Item>
+    static Item *openSlot(void *&slots, size_t count, unsigned rank) {
+        Item *array = static_cast<Item *>(slots);
+        if (capacityOf(count + 1) != capacityOf(count)) {
+            Item *grown = new Item[capacityOf(count + 1)];
+            std::move(array, array + rank, grown);
+            std::move(array + rank, array + count, grown + rank + 1);
+            delete[] array;
+            slots = array = grown;
+        } else {
+            std::move_backward(array + rank, array + count, array + count + 1);
+        }
+        return array + rank;
+    }
+
+    /**
+     * @brief Close the slot at position rank of a packed array holding count items, shrinking it
+     * when it falls to half
+     */
+    template<class Item>
+    static void closeSlot(void *&slots, size_t count, unsigned rank) {
+        Item *array = static_cast<Item *>(slots);
+        if (capacityOf(count - 1) != capacityOf(count)) {
+            Item *shrunk = count == 1 ? nullptr : new Item[capacityOf(count - 1)];
+            std::move(array, array + rank, shrunk);
+            std::move(array + rank + 1, array + count, shrunk + rank);
+            delete[] array;
+            slots = shrunk;
+        } else {
+            std::move(array + rank + 1, array + count, array + rank);
+            array[count - 1] = Item();
+        }
+    }
+
+    void makeEmpty(TrieNode *t, int level) {
+        if (level == LEAF) {
+            delete[] elements(t);
+        } else {
+            int count = __builtin_popcountll(t->bits);
+            for (int i = 0; i < count; ++i) {
+                makeEmpty(children(t) + i, level + 1);
+            }
+            delete[] children(t);
+        }
+        t->bits = 0;
+        t->slots = nullptr;
+    }
+
+    // the smallest element under t, which is always the first slot
+    static set<KEY, OTHER> *minimum(const TrieNode *t, int level) {
+        for (; level < LEAF; ++level) {
+            t = children(t);
+        }
+        return elements(t);
+    }
+
+    // the largest element under t, which is always the last slot
+    static set<KEY, OTHER> *maximum(const TrieNode *t, int level) {
+        for (; level < LEAF; ++level) {
+            t = children(t) + __builtin_popcountll(t->bits) - 1;
+        }
+        return elements(t) + __builtin_popcountll(t->bits) - 1;
+    }
+
+    /**
+     * @brief Go down along u as far as the bitmaps allow, path[0..level] are the nodes visited
+     *
+     * @return int the deepest level reached
+     */
+    int descend(uint32_t u, const TrieNode **path) const {
+        const TrieNode *t = &root;
+        int level = 0;
+        for (;;) {
+            path[level] = t;
+            unsigned idx = indexOf(u, level);
+            if (level == LEAF || !(t->bits >> idx & 1)) {
+                return level;
+            }
+            t = children(t) + rankOf(t->bits, idx);
+            ++level;
+        }
+    }
+
+public:
+    BitmapTrie() = default;
+
+    ~BitmapTrie() {
+        makeEmpty(&root, 0);
+    }
+
+    BitmapTrie(const BitmapTrie &) = delete;
+    BitmapTrie &operator=(const BitmapTrie &) = delete;
+
+    size_t size() const {
+        return current_size;
+    }
+
+    set<KEY, OTHER> *find(const KEY &x) const {
+        uint32_t u = encode(x);
+        const TrieNode *t = &root;
+        for (int level = 0; level < LEAF; ++level) {
+            unsigned idx = indexOf(u, level);
+            if (!(t->bits >> idx & 1)) {
+                return nullptr;
+            }
+            t = children(t) + rankOf(t->bits, idx);
+        }
+        unsigned idx = u & 63;
+        if (!(t->bits >> idx & 1)) {
+            return nullptr;
+        }
+        return elements(t) + rankOf(t->bits, idx);
+    }
+
+    /**
+     * @brief Insert x, repetition makes no operations
+     */
+    void insert(const set<KEY, OTHER> &x) {
+        uint32_t u = encode(x.key);
+        TrieNode *t = &root;
+        for (int level = 0; level < LEAF; ++level) {
+            unsigned idx = indexOf(u, level), rank = rankOf(t->bits, idx);
+            if (!(t->bits >> idx & 1)) {
+                *openSlot<TrieNode>(t->slots, __builtin_popcountll(t->bits), rank) = TrieNode();
+                t->bits |= uint64_t(1) << idx;
+            }
+            t = children(t) + rank;
+        }
+        unsigned idx = u & 63;
+        if (t->bits >> idx & 1) {
+            return;
+        }
+        *openSlot<set<KEY, OTHER>>(t->slots, __builtin_popcountll(t->bits), rankOf(t->bits, idx)) = x;
+        t->bits |= uint64_t(1) << idx;
+        ++current_size;
+    }
+
+    /**
+     * @brief Remove the element with key x, the nodes left empty are freed bottom-up
+     */
+    void remove(const KEY &x) {
+        uint32_t u = encode(x);
+        const TrieNode *path[LEVELS];
+        if (descend(u, path) != LEAF || !(path[LEAF]->bits >> (u & 63) & 1)) {
+            return;
+        }
+        --current_size;
+        for (int level = LEAF; level >= 0; --level) {
+            TrieNode *t = const_cast<TrieNode *>(path[level]);
+            unsigned idx = indexOf(u, level), rank = rankOf(t->bits, idx);
+            if (level == LEAF) {
+                closeSlot<set<KEY, OTHER>>(t->slots, __builtin_popcountll(t->bits), rank);
+            } else {
+                closeSlot<TrieNode>(t->slots, __builtin_popcountll(t->bits), rank);
+            }
+            t->bits &= ~(uint64_t(1) << idx);
+            if (t->bits != 0) {
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief The element with the smallest key > x, nullptr if there is none
+     */
+    set<KEY, OTHER> *successor(const KEY &x) const {
+        uint32_t u = encode(x);
+        const TrieNode *path[LEVELS];
+        for (int level = descend(u, path); level >= 0; --level) {
+            unsigned idx = indexOf(u, level);
+            uint64_t above = idx == 63 ? 0 : path[level]->bits & (~uint64_t(0) << (idx + 1));
+            if (above != 0) {
+                unsigned rank = rankOf(path[level]->bits, __builtin_ctzll(above));
+                if (level == LEAF) {
+                    return elements(path[level]) + rank;
+                }
+                return minimum(children(path[level]) + rank, level + 1);
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief The element with the largest key < x, nullptr if there is none
+     */
+    set<KEY, OTHER> *predecessor(const KEY &x) const {
+        uint32_t u = encode(x);
+        const TrieNode *path[LEVELS];
+        for (int level = descend(u, path); level >= 0; --level) {
+            unsigned idx = indexOf(u, level);
+            uint64_t below = path[level]->bits & ((uint64_t(1) << idx) - 1);
+            if (below != 0) {
+                unsigned rank = __builtin_popcountll(below) - 1;
+                if (level == LEAF) {
+                    return elements(path[level]) + rank;
+                }
+                return maximum(children(path[level]) + rank, level + 1);
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief The element with the smallest key, nullptr if empty
+     */
+    set<KEY, OTHER> *minimum() const {
+        return current_size == 0 ? nullptr : minimum(&root, 0);
+    }
+
+    /**
+     * @brief The element with the largest key, nullptr if empty
+     */
+    set<KEY, OTHER> *maximum() const {
+        return current_size == 0 ? nullptr : maximum(&root, 0);
+    }
+
+    /**
+     * @brief Return the height of the trie, the number of levels below the root is fixed
+     *
+     * @return int
+     */
+    int height() const {
+        return current_size == 0 ? 0 : LEVELS;
+    }
+};
+
+#ifndef BENCHMARK_NO_MAIN
+int main(int argc, char *argv[]) {
+    std::cout << "--- Bitmap Trie Tests ---" << std::endl;
+    BitmapTrie<int, std::string> ports;
+    ports.insert({443, "https"});
+    ports.insert({22, "ssh"});
+    ports.insert({80, "http"});
+    ports.insert({8080, "http-alt"});
+    ports.insert({-1, "invalid"});
+    ports.remove(-1);
+    auto result = ports.find(80);
+    std::cout << "find(80): " << (result ? result->other : "not found") << ", find(-1): "
+              << (ports.find(-1) ? "found" : "not found") << " (Expected: http, not found)" << std::endl;
+    std::cout << "successor(80): " << ports.successor(80)->other << ", predecessor(80): "
+              << ports.predecessor(80)->other << ", successor(8080): "
+              << (ports.successor(8080) ? "found" : "none") << " (Expected: https, ssh, none)" << std::endl;
+
+    // random operations against std::map, on clustered keys so the leaves fill up
+    std::mt19937 gen(2025);
+    BitmapTrie<int, int> checked;
+    std::map<int, int> expected;
+    bool pass = true;
+    for (int i = 0; i < 500000 && pass; ++i) {
+        int key = (gen() % 2 ? int(gen()) : int(gen() % 20000) - 10000), op = gen() % 100;
+        if (op < 45) {
+            checked.insert({key, i});
+            expected.emplace(key, i);
+        } else if (op < 80) {
+            checked.remove(key);
+            expected.erase(key);
+        } else {
+            auto it = expected.upper_bound(key);
+            set<int, int> *next = checked.successor(key);
+            pass = (it == expected.end()) ? next == nullptr : (next != nullptr && next->key == it->first && next->other == it->second);
+            it = expected.lower_bound(key);
+            set<int, int> *previous = checked.predecessor(key);
+            pass = pass && ((it == expected.begin()) ? previous == nullptr : (previous != nullptr && previous->key == std::prev(it)->first));
+            set<int, int> *x = checked.find(key);
+            pass = pass && (expected.count(key) ? x != nullptr && x->key == key : x == nullptr);
+        }
+        pass = pass && checked.size() == expected.size();
+    }
+    pass = pass && (expected.empty() || (checked.minimum()->key == expected.begin()->first &&
+                                        checked.maximum()->key == expected.rbegin()->first));
+    std::cout << "Random operations: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+    // usage: BitmapTrie [keys] [queries]
+    size_t n = argc > 1 ? std::stoull(argv[1]) : 100000000;
+    size_t queries = argc > 2 ? std::stoull(argv[2]) : 10000000;
+    std::cout << "\n--- Benchmark: " << n << " random 32-bit keys, " << queries << " successor queries ---" << std::endl;
+    std::mt19937 gen32(2025);
+    std::vector<uint32_t> keys(n), probes(queries);
+    for (auto &key : keys) {
+        key = gen32();
+    }
+    // the probes are present keys, since sjtu::map finds a successor by find and ++
+    for (auto &probe : probes) {
+        probe = keys[gen32() % n];
+    }
+
+    uint64_t trie_sum = 0, map_sum = 0;
+    double trie_build, trie_time, map_build, map_time;
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        BitmapTrie<uint32_t, uint32_t> trie;
+        for (uint32_t key : keys) {
+            trie.insert({key, key});
+        }
+        auto built = std::chrono::high_resolution_clock::now();
+        for (uint32_t probe : probes) {
+            set<uint32_t, uint32_t> *next = trie.successor(probe);
+            trie_sum += next == nullptr ? 0 : next->key;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        trie_build = std::chrono::duration<double>(built - start).count();
+        trie_time = std::chrono::duration<double>(end - built).count();
+    }
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        sjtu::map<uint32_t, uint32_t> tree;
+        for (uint32_t key : keys) {
+            tree.insert(sjtu::pair<const uint32_t, uint32_t>(key, key));
+        }
+        auto built = std::chrono::high_resolution_clock::now();
+        for (uint32_t probe : probes) {
+            auto it = tree.find(probe);
+            ++it;
+            map_sum += it == tree.end() ? 0 : it->first;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        map_build = std::chrono::duration<double>(built - start).count();
+        map_time = std::chrono::duration<double>(end - built).count();
+    }
+
+    std::cout << "BitmapTrie: build " << n / trie_build / 1e6 << " M/s, successor " << queries / trie_time / 1e6
+              << " M/s" << std::endl;
+    std::cout << "sjtu::map: build " << n / map_build / 1e6 << " M/s, successor " << queries / map_time / 1e6
+              << " M/s" << std::endl;
+    std::cout << "Same results: " << (trie_sum == map_sum ? "PASS" : "FAIL") << std::endl;
+    return 0;
+}
+#endif
@@ -0,0 +1,538 @@
+/*
+Filters which answer "surely not here" for most of the keys missing from a table, without touching it:
+a blocked Bloom filter and a cuckoo filter (which can also delete), and filteredTable, which puts either
+of them in front of any dynamicSearchTable so that the lookups of missing keys rarely reach the table.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "dynamicSearchTable.hpp"
+
+// splitmix64 finalizer, the hash functors of integers are the identity
+inline uint64_t mixHash(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+/*
+Split block Bloom filter (Putze, Sanders and Singler, "Cache-, hash- and space-efficient Bloom filters",
+2007; the layout of Impala and Parquet): a key sets 8 bits in one block of 256 bits, one bit in each
+32-bit word, so a lookup reads a single cache line, and the 8 bit positions are 8 multiplications
+which AVX2 computes and tests at once (compile with -mavx2, a scalar loop otherwise).
+*/
+template<class Key, class Hash = std::hash<Key>>
+class blockedBloomFilter {
+private:
+    static const int WORDS = 8;
+    static const int BLOCK_BITS = 32 * WORDS;
+
+    struct alignas(32) block {
+        uint32_t word[WORDS];
+    };
+
+    block *blocks;
+    size_t block_count;
+    Hash hasher;
+
+    // odd multipliers, bit i of a key is the top 5 bits of its low hash times SALT[i]
+    static constexpr uint32_t SALT[WORDS] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                             0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+    block &blockOf(uint64_t h) const {
+        // the high half of the hash picks the block, by multiply and shift instead of a modulo
+        return blocks[(uint64_t(uint32_t(h >> 32)) * block_count) >> 32];
+    }
+
+#ifdef __AVX2__
+    static __m256i bitsOf(uint32_t h) {
+        const __m256i salt = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(SALT));
+        __m256i shift = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(int(h)), salt), 27);
+        return _mm256_sllv_epi32(_mm256_set1_epi32(1), shift);
+    }
+#endif
+
+public:
+    /**
+     * @brief The false-positive rate at bits_per_key: a block holds Poisson(256 / bits_per_key) keys,
+     * and with j keys every word has a given bit set with probability 1 - (31/32)^j
+     */
+    static double falsePositiveRate(double bits_per_key) {
+        double lambda = BLOCK_BITS / bits_per_key, probability = std::exp(-lambda), rate = 0;
+        for (int j = 0; j < lambda + 20 * std::sqrt(lambda) + 20; ++j) {
+            rate += probability * std::pow(1 - std::pow(31.0 / 32, j), WORDS);
+            probability *= lambda / (j + 1);
+        }
+        return rate;
+    }
+
+    /**
+     * @brief Construct a new blockedBloomFilter object
+     *
+     * @param expected the number of keys it is sized for, more keys raise the false-positive rate
+     * @param fp_rate the false-positive rate wanted at expected keys
+     */
+    explicit blockedBloomFilter(size_t expected, double fp_rate = 0.01, const Hash &hasher_ = Hash()) : hasher(hasher_) {
+        if (!(fp_rate > 0 && fp_rate < 1)) {
+            throw std::invalid_argument("The false-positive rate should be in (0, 1)!");
+        }
+        double bits_per_key = 4;
+        while (falsePositiveRate(bits_per_key) > fp_rate && bits_per_key < 256) {
+            bits_per_key += 0.25;
+        }
+        block_count = std::max<size_t>(1, size_t(std::ceil(std::max<size_t>(expected, 1) * bits_per_key / BLOCK_BITS)));
+        blocks = new block[block_count]();
+    }
+
+    ~blockedBloomFilter() {
+        delete[] blocks;
+    }
+
+    blockedBloomFilter(const blockedBloomFilter &) = delete;
+    blockedBloomFilter &operator=(const blockedBloomFilter &) = delete;
+
+    void insert(const Key &x) {
+        uint64_t h = mixHash(hasher(x));
+        block &b = blockOf(h);
+#ifdef __AVX2__
+        __m256i *p = reinterpret_cast<__m256i *>(b.word);
+        _mm256_store_si256(p, _mm256_or_si256(_mm256_load_si256(p), bitsOf(uint32_t(h))));
+#else
+        for (int i = 0; i < WORDS; ++i) {
+            b.word[i] |= 1U << ((uint32_t(h) * SALT[i]) >> 27);
+        }
+#endif
+    }
+
+    /**
+     * @brief false if x was surely never inserted
+     */
+    bool contains(const Key &x) const {
+        uint64_t h = mixHash(hasher(x));
+        const block &b = blockOf(h);
+#ifdef __AVX2__
+        return _mm256_testc_si256(_mm256_load_si256(reinterpret_cast<const __m256i *>(b.word)), bitsOf(uint32_t(h)));
+#else
+        bool result = true;
+        for (int i = 0; i < WORDS; ++i) {
+            result &= (b.word[i] >> ((uint32_t(h) * SALT[i]) >> 27)) & 1;
+        }
+        return result;
+#endif
+    }
+
+    /**
+     * @brief A Bloom filter can not delete: the bits of x stay set, which only raises the false-positive rate
+     */
+    void remove(const Key &) {}
+
+    /**
+     * @brief the size of the filter in bytes
+     */
+    size_t bytes() const {
+        return block_count * sizeof(block);
+    }
+};
+
+/*
+Cuckoo filter (Fan, Andersen, Kaminsky and Mitzenmacher, "Cuckoo Filter: Practically Better Than Bloom", 2014):
+a 16-bit fingerprint of every key in one of two buckets of 4 fingerprints, where the second bucket is the
+first xor a hash of the fingerprint, so a fingerprint can move without the key. A bucket is one 64-bit word
+and is searched for a fingerprint with a few word operations (SWAR). It deletes, the false-positive rate
+is at most 8 / 2^16, and a level holds up to about 95% of its slots.
+The fingerprints can not be rehashed into a larger table, so a full level stays as it is and the filter
+grows by a new level of twice its buckets: there is no capacity, and every level adds 8 / 2^16 to the
+false-positive rate of the keys it holds.
+*/
+template<class Key, class Hash = std::hash<Key>>
+class cuckooFilter {
+private:
+    static const int SLOTS = 4;
+    static const int MAX_KICKS = 500;
+    static const uint64_t LOW_BITS = 0x0001000100010001ull;
+    static const uint64_t HIGH_BITS = 0x8000800080008000ull;
+
+    struct level {
+        std::vector<uint64_t> buckets;// 4 fingerprints of 16 bits, 0 for an empty slot
+        size_t mask;
+        // the fingerprint left without a slot by a failed insertion, which closes the level to insertions
+        uint16_t victim;
+        size_t victim_bucket;
+
+        explicit level(size_t count) : buckets(count, 0), mask(count - 1), victim(0), victim_bucket(0) {}
+
+        size_t alternate(size_t bucket, uint16_t fingerprint) const {
+            return (bucket ^ size_t(fingerprint * 0x5BD1E995ull)) & mask;
+        }
+
+        bool put(size_t bucket, uint16_t fingerprint) {
+            for (int i = 0; i < SLOTS; ++i) {
+                if (slot(buckets[bucket], i) == 0) {
+                    setSlot(buckets[bucket], i, fingerprint);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool erase(size_t bucket, uint16_t fingerprint) {
+            for (int i = 0; i < SLOTS; ++i) {
+                if (slot(buckets[bucket], i) == fingerprint) {
+                    setSlot(buckets[bucket], i, 0);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool contains(uint64_t h, uint16_t fingerprint) const {
+            size_t bucket = (h >> 32) & mask, other = alternate(bucket, fingerprint);
+            return has(buckets[bucket], fingerprint) || has(buckets[other], fingerprint) ||
+                   (victim == fingerprint && (victim_bucket == bucket || victim_bucket == other));
+        }
+
+        bool remove(uint64_t h, uint16_t fingerprint) {
+            size_t bucket = (h >> 32) & mask, other = alternate(bucket, fingerprint);
+            if (victim == fingerprint && (victim_bucket == bucket || victim_bucket == other)) {
+                victim = 0;
+            } else if (!erase(bucket, fingerprint) && !erase(other, fingerprint)) {
+                return false;
+            }
+            if (victim != 0 && put(victim_bucket, victim)) {
+                victim = 0;// a slot has been freed for the victim
+            }
+            return true;
+        }
+    };
+
+    std::vector<level> levels;// the last one takes the insertions
+    Hash hasher;
+    std::mt19937 gen;
+
+    uint16_t fingerprintOf(uint64_t h) const {
+        return uint16_t(h) == 0 ? 1 : uint16_t(h);
+    }
+
+    // whether one of the 4 slots of bucket equals fingerprint: a slot of x is zero where they are equal
+    static bool has(uint64_t bucket, uint16_t fingerprint) {
+        uint64_t x = bucket ^ (LOW_BITS * fingerprint);
+        return ((x - LOW_BITS) & ~x & HIGH_BITS) != 0;
+    }
+
+    static uint16_t slot(uint64_t bucket, int i) {
+        return uint16_t(bucket >> (16 * i));
+    }
+
+    static void setSlot(uint64_t &bucket, int i, uint16_t fingerprint) {
+        bucket = (bucket & ~(0xFFFFull << (16 * i))) | (uint64_t(fingerprint) << (16 * i));
+    }
+
+public:
+    /**
+     * @brief Construct a new cuckooFilter object
+     *
+     * @param expected the number of keys of the first level, a power of two of buckets with room for
+     * expected / 0.9 keys; more keys add levels
+     */
+    explicit cuckooFilter(size_t expected, const Hash &hasher_ = Hash()) : hasher(hasher_), gen(2025) {
+        size_t count = 1;
+        while (count * SLOTS * 0.9 < expected) {
+            count *= 2;
+        }
+        levels.emplace_back(count);
+    }
+
+    cuckooFilter(const cuckooFilter &) = delete;
+    cuckooFilter &operator=(const cuckooFilter &) = delete;
+
+    /**
+     * @brief Add the fingerprint of x, kicking fingerprints to their other bucket if both are full,
+     * in a new level if the last one is full
+     */
+    void insert(const Key &x) {
+        if (levels.back().victim != 0) {
+            levels.emplace_back(levels.back().buckets.size() * 2);
+        }
+        level &last = levels.back();
+        uint64_t h = mixHash(hasher(x));
+        uint16_t fingerprint = fingerprintOf(h);
+        size_t bucket = (h >> 32) & last.mask;
+        if (last.put(bucket, fingerprint) || last.put(last.alternate(bucket, fingerprint), fingerprint)) {
+            return;
+        }
+        bucket = gen() % 2 == 0 ? bucket : last.alternate(bucket, fingerprint);
+        for (int kick = 0; kick < MAX_KICKS; ++kick) {
+            int i = int(gen() % SLOTS);
+            uint16_t kicked = slot(last.buckets[bucket], i);
+            setSlot(last.buckets[bucket], i, fingerprint);
+            fingerprint = kicked;
+            bucket = last.alternate(bucket, fingerprint);
+            if (last.put(bucket, fingerprint)) {
+                return;
+            }
+        }
+        last.victim = fingerprint;
+        last.victim_bucket = bucket;
+    }
+
+    /**
+     * @brief false if x was surely never inserted (or has been removed)
+     */
+    bool contains(const Key &x) const {
+        uint64_t h = mixHash(hasher(x));
+        for (const level &l : levels) {
+            if (l.contains(h, fingerprintOf(h))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Remove one fingerprint of x, which must have been inserted: removing a key which was
+     * never inserted may remove the fingerprint of another key.
+     * Within a level, equal fingerprints in the same buckets stand for each other, but across levels the
+     * one in another level may be another key's, so a fingerprint matching in several levels is kept,
+     * leaving a false positive instead of a false negative.
+     */
+    void remove(const Key &x) {
+        uint64_t h = mixHash(hasher(x));
+        level *match = nullptr;
+        for (level &l : levels) {
+            if (l.contains(h, fingerprintOf(h))) {
+                if (match != nullptr) {
+                    return;
+                }
+                match = &l;
+            }
+        }
+        if (match != nullptr) {
+            match->remove(h, fingerprintOf(h));
+        }
+    }
+
+    /**
+     * @brief the size of the filter in bytes
+     */
+    size_t bytes() const {
+        size_t total = 0;
+        for (const level &l : levels) {
+            total += l.buckets.size() * sizeof(uint64_t);
+        }
+        return total;
+    }
+
+    size_t levelCount() const {
+        return levels.size();
+    }
+};
+
+/**
+ * @brief A filter in front of a dynamicSearchTable: a lookup goes to the table only if the filter
+ * may contain the key. Every change of the table must go through the filteredTable, which starts empty.
+ *
+ * @tparam Filter blockedBloomFilter or cuckooFilter
+ */
+template<class Key, class Other, class Filter>
+class filteredTable : public dynamicSearchTable<Key, Other> {
+private:
+    dynamicSearchTable<Key, Other> &table;
+    Filter filter_;
+
+public:
+    /**
+     * @brief Construct a new filteredTable object
+     *
+     * @param table_ the empty table to put the filter in front of
+     * @param args the arguments of the constructor of the filter
+     */
+    template<class... Args>
+    explicit filteredTable(dynamicSearchTable<Key, Other> &table_, Args &&...args)
+        : table(table_), filter_(std::forward<Args>(args)...) {}
+
+    set<Key, Other> *find(const Key &x) const {
+        return filter_.contains(x) ? table.find(x) : nullptr;
+    }
+
+    void insert(const set<Key, Other> &x) {
+        // a key the filter rules out is surely new, only the others need a look in the table.
+        // The filter goes first: if the table throws, the key left in the filter is only a false positive
+        if (!filter_.contains(x.key) || table.find(x.key) == nullptr) {
+            filter_.insert(x.key);
+            table.insert(x);
+        }
+    }
+
+    void remove(const Key &x) {
+        if (find(x) != nullptr) {
+            table.remove(x);
+            filter_.remove(x);
+        }
+    }
+
+    const Filter &filter() const {
+        return filter_;
+    }
+};
+
+#ifndef BENCHMARK_NO_MAIN
+#define BENCHMARK_NO_MAIN
+#include "AVLTree.cpp"
+#include "close_Hash_Table.cpp"
+#undef BENCHMARK_NO_MAIN
+
+/**
+ * @brief Time the lookups of queries in table, in M/s, found counts the keys found
+ */
+double lookupRate(const dynamicSearchTable<int, int> &table, const std::vector<int> &queries, size_t &found) {
+    found = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int x : queries) {
+        found += table.find(x) != nullptr;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return queries.size() / elapsed.count() / 1e6;
+}
+
+/**
+ * @brief Fill a Table with keys, then time the random lookups without a filter and behind a Bloom
+ * filter at 1% and 0.1% and a cuckoo filter
+ */
+template<class Table>
+void compare(const std::string &name, const std::vector<int> &keys, const std::vector<int> &queries, Table &plain,
+             Table &behind_bloom, Table &behind_precise_bloom, Table &behind_cuckoo) {
+    filteredTable<int, int, blockedBloomFilter<int>> bloom(behind_bloom, keys.size(), 0.01);
+    filteredTable<int, int, blockedBloomFilter<int>> precise_bloom(behind_precise_bloom, keys.size(), 0.001);
+    filteredTable<int, int, cuckooFilter<int>> cuckoo(behind_cuckoo, keys.size());
+    for (int x : keys) {
+        plain.insert({x, x});
+        bloom.insert({x, x});
+        precise_bloom.insert({x, x});
+        cuckoo.insert({x, x});
+    }
+
+    size_t expected, found;
+    size_t positive = 0;// queries which are keys, to tell the false positives apart
+    {
+        std::vector<int> sorted(keys);
+        std::sort(sorted.begin(), sorted.end());
+        for (int x : queries) {
+            positive += std::binary_search(sorted.begin(), sorted.end(), x);
+        }
+    }
+    std::cout << name << ", " << keys.size() << " keys, " << queries.size() << " lookups (" << positive << " hits)"
+              << std::endl;
+    double rate = lookupRate(plain, queries, expected);
+    std::cout << "  no filter: " << rate << " M/s" << std::endl;
+
+    auto report = [&](const std::string &filter_name, const dynamicSearchTable<int, int> &table, size_t bytes,
+                      auto contains) {
+        double filtered_rate = lookupRate(table, queries, found);
+        size_t passed = 0;
+        for (int x : queries) {
+            passed += contains(x);
+        }
+        std::cout << "  " << filter_name << ": " << filtered_rate << " M/s, " << bytes * 8.0 / keys.size()
+                  << " bits per key, false positives " << double(passed - positive) / (queries.size() - positive)
+                  << ", " << (found == expected ? "PASS" : "FAIL") << std::endl;
+    };
+    report("Bloom filter 1%", bloom, bloom.filter().bytes(), [&](int x) { return bloom.filter().contains(x); });
+    report("Bloom filter 0.1%", precise_bloom, precise_bloom.filter().bytes(),
+           [&](int x) { return precise_bloom.filter().contains(x); });
+    report("cuckoo filter", cuckoo, cuckoo.filter().bytes(), [&](int x) { return cuckoo.filter().contains(x); });
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "--- Filter Tests ---" << std::endl;
+    close_Hash_Table<int, std::string> table;
+    filteredTable<int, std::string, cuckooFilter<int>> s(table, 100);
+    s.insert({10, "Ten"});
+    s.insert({18, "Eighteen"});
+    s.remove(18);
+    auto result = s.find(10);
+    std::cout << "find(10): " << (result ? result->other : "not found") << ", find(18): "
+              << (s.find(18) ? "found" : "not found") << " (Expected: Ten, not found)" << std::endl;
+
+    // no false negatives, also while the cuckoo filter deletes
+    std::mt19937 gen(2025);
+    blockedBloomFilter<int> bloom(100000, 0.01);
+    cuckooFilter<int> cuckoo(100000);
+    std::vector<int> inserted;
+    bool pass = true;
+    for (int i = 0; i < 100000; ++i) {
+        int x = int(gen());
+        bloom.insert(x);
+        cuckoo.insert(x);
+        inserted.push_back(x);
+        if (i % 3 == 2) {
+            cuckoo.remove(inserted[i - 1]);
+        }
+    }
+    for (int i = 0; i < 100000; ++i) {
+        pass = pass && bloom.contains(inserted[i]) && (i % 3 == 1 || cuckoo.contains(inserted[i]));
+    }
+    std::cout << "No false negatives: " << (pass ? "PASS" : "FAIL") << ", Bloom filter of "
+              << bloom.bytes() * 8.0 / 100000 << " bits per key for 1% (expected rate "
+              << blockedBloomFilter<int>::falsePositiveRate(bloom.bytes() * 8.0 / 100000) << ")" << std::endl;
+
+    // far more keys than the cuckoo filter is sized for: it grows by levels and still finds every key
+    {
+        close_Hash_Table<int, int> grown;
+        filteredTable<int, int, cuckooFilter<int>> f(grown, 1000);
+        for (int i = 0; i < 100000; ++i) f.insert({i, i});
+        for (int i = 0; i < 100000; i += 2) f.remove(i);
+        pass = true;
+        for (int i = 0; i < 100000; ++i) {
+            pass = pass && (f.find(i) != nullptr) == (i % 2 == 1);
+        }
+        std::cout << "Past the expected size: " << (pass ? "PASS" : "FAIL") << ", " << f.filter().levelCount()
+                  << " levels" << std::endl;
+    }
+
+    // the workload of close_Hash_Table.cpp: 8000 keys of [1, 1e9], 1M random lookups, nearly all missing
+    std::uniform_int_distribution<> dis(1, 1000000000);
+    std::vector<int> keys(8000), queries(1000000);
+    for (int &x : keys) x = dis(gen);
+    for (int &x : queries) x = dis(gen);
+    std::cout << "\n--- Benchmark: lookups of random keys (M/s) ---" << std::endl;
+    {
+        close_Hash_Table<int, int> a(10000), b(10000), c(10000), d(10000);
+        compare("close_Hash_Table", keys, queries, a, b, c, d);
+    }
+    {
+        AVLTree<int, int> a, b, c, d;
+        compare("AVLTree", keys, queries, a, b, c, d);
+    }
+
+    // usage: BloomFilter [keys of the large tables]
+    size_t n = argc > 1 ? std::stoull(argv[1]) : 4000000;
+    keys.resize(n);
+    queries.resize(10000000);
+    for (int &x : keys) x = dis(gen);
+    for (int &x : queries) x = dis(gen);
+    {
+        close_Hash_Table<int, int> a, b, c, d;
+        compare("close_Hash_Table", keys, queries, a, b, c, d);
+    }
+    {
+        AVLTree<int, int> a, b, c, d;
+        compare("AVLTree", keys, queries, a, b, c, d);
+    }
+    return 0;
+}
+#endif
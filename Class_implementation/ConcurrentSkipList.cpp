@@ -0,0 +1,526 @@
+/*
+Lock-free skip list (Herlihy & Shavit, "The Art of Multiprocessor Programming", ch. 14;
+Fraser, "Practical lock-freedom", 2004) with an sjtu::map style interface and epoch-based
+memory reclamation, as an ordered index which can be read and written from many threads.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "epochDomain.hpp"
+#include "map.hpp"
+#include "utility.hpp"
+
+/**
+ * @brief Lock-free ordered map.
+ * A node is logically removed by marking the low bit of its next pointers, top level first and
+ * level 0 last, and physically unlinked by any traversal which meets it. Values are fixed at
+ * insertion like sjtu::map::insert, which does not overwrite either.
+ * size() is exact only when no operation is running.
+ * Iterators are valid while the calling thread holds an epochGuard.
+ *
+ * @tparam Key
+ * @tparam T
+ * @tparam Compare
+ */
+template<class Key, class T, class Compare = std::less<Key>>
+class ConcurrentSkipList {
+public:
+    typedef sjtu::pair<const Key, T> value_type;
+
+private:
+    static const int MAX_LEVEL = 32;
+
+    struct Node {
+        int top_level;
+        std::atomic<int> finished{0};// the inserter and the eraser are done with the node
+        // the element is stored in the node so that a search reads one cache line per node,
+        // it is not constructed in the head
+        alignas(value_type) unsigned char storage[sizeof(value_type)];
+        std::atomic<uintptr_t> next[1];// top_level entries, the low bit marks a removed node
+
+        value_type *data() {
+            return reinterpret_cast<value_type *>(storage);
+        }
+
+        static Node *create(const value_type *value, int levels) {
+            void *memory = ::operator new(sizeof(Node) + (levels - 1) * sizeof(std::atomic<uintptr_t>));
+            Node *node = new (memory) Node;
+            if (value != nullptr) new (node->storage) value_type(*value);
+            node->top_level = levels;
+            node->next[0].store(0, std::memory_order_relaxed);
+            for (int i = 1; i < levels; ++i) {
+                new (&node->next[i]) std::atomic<uintptr_t>(0);
+            }
+            return node;
+        }
+
+        static void destroy(void *memory) {
+            Node *node = static_cast<Node *>(memory);
+            node->data()->~value_type();
+            node->~Node();
+            ::operator delete(memory);
+        }
+
+        // the head holds no element
+        static void destroyHead(Node *node) {
+            node->~Node();
+            ::operator delete(node);
+        }
+    };
+
+    static bool marked(uintptr_t p) {
+        return p & 1;
+    }
+
+    static uintptr_t mark(uintptr_t p) {
+        return p | 1;
+    }
+
+    static Node *pointer(uintptr_t p) {
+        return reinterpret_cast<Node *>(p & ~uintptr_t(1));
+    }
+
+    static uintptr_t raw(Node *p) {
+        return reinterpret_cast<uintptr_t>(p);
+    }
+
+    Node *head;
+    std::atomic<long long> current_size{0};
+    Compare less;
+
+    static int randomLevel() {
+        thread_local uint64_t state = std::hash<std::thread::id>()(std::this_thread::get_id()) * 0x9E3779B97F4A7C15ull + 1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        // p = 1/2 per level
+        int level = 1;
+        uint64_t bits = state;
+        while ((bits & 1) && level < MAX_LEVEL) {
+            ++level;
+            bits >>= 1;
+        }
+        return level;
+    }
+
+    /**
+     * @brief the last node < key (preds) and the first node >= key (succs) on every level,
+     * unlinking the marked nodes on the way
+     *
+     * @return true if succs[0] has the key
+     */
+    bool find(const Key &key, Node **preds, Node **succs) const {
+    retry:
+        Node *pred = head;
+        Node *curr = nullptr;
+        for (int level = MAX_LEVEL - 1; level >= 0; --level) {
+            curr = pointer(pred->next[level].load(std::memory_order_acquire));
+            while (curr != nullptr) {
+                uintptr_t succ = curr->next[level].load(std::memory_order_acquire);
+                while (marked(succ)) {
+                    // curr is removed, snip it out of this level
+                    uintptr_t expected = raw(curr);
+                    if (!pred->next[level].compare_exchange_strong(expected, succ & ~uintptr_t(1), std::memory_order_acq_rel)) {
+                        goto retry;
+                    }
+                    curr = pointer(succ);
+                    if (curr == nullptr) break;
+                    succ = curr->next[level].load(std::memory_order_acquire);
+                }
+                if (curr != nullptr && less(curr->data()->first, key)) {
+                    pred = curr;
+                    curr = pointer(succ);
+                } else {
+                    break;
+                }
+            }
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        return curr != nullptr && !less(key, curr->data()->first);
+    }
+
+    /**
+     * @brief the inserter and the eraser each call this once they are done with node,
+     * the second one unlinks whatever is left of it and retires it
+     */
+    void finish(Node *node) {
+        if (node->finished.fetch_add(1, std::memory_order_acq_rel) == 1) {
+            Node *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+            find(node->data()->first, preds, succs);
+            epochDomain::retire(node, &Node::destroy);
+        }
+    }
+
+public:
+    class iterator {
+        friend class ConcurrentSkipList;
+
+    private:
+        Node *node;
+
+        explicit iterator(Node *node_) : node(node_) {}
+
+    public:
+        iterator() : node(nullptr) {}
+
+        value_type &operator*() const {
+            return *node->data();
+        }
+
+        value_type *operator->() const {
+            return node->data();
+        }
+
+        // the next node on level 0 which is not removed
+        iterator &operator++() {
+            node = pointer(node->next[0].load(std::memory_order_acquire));
+            while (node != nullptr && marked(node->next[0].load(std::memory_order_acquire))) {
+                node = pointer(node->next[0].load(std::memory_order_acquire));
+            }
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        bool operator==(const iterator &rhs) const {
+            return node == rhs.node;
+        }
+
+        bool operator!=(const iterator &rhs) const {
+            return node != rhs.node;
+        }
+    };
+
+    ConcurrentSkipList() {
+        head = Node::create(nullptr, MAX_LEVEL);
+    }
+
+    /**
+     * @brief no other thread may use the list any more
+     */
+    ~ConcurrentSkipList() {
+        Node *t = pointer(head->next[0].load());
+        while (t != nullptr) {
+            Node *next = pointer(t->next[0].load());
+            // a removed node which is still linked is owned by the retire list
+            if (!marked(t->next[0].load())) {
+                Node::destroy(t);
+            }
+            t = next;
+        }
+        Node::destroyHead(head);
+    }
+
+    ConcurrentSkipList(const ConcurrentSkipList &) = delete;
+    ConcurrentSkipList &operator=(const ConcurrentSkipList &) = delete;
+
+    size_t size() const {
+        long long n = current_size.load(std::memory_order_relaxed);
+        return n < 0 ? 0 : n;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * @brief insert value if its key is not in the list
+     *
+     * @return a pair, the second one is true if the insertion happens
+     */
+    sjtu::pair<iterator, bool> insert(const value_type &value) {
+        epochGuard guard;
+        Node *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+        int top_level = randomLevel();
+        Node *node = nullptr;
+        while (true) {
+            if (find(value.first, preds, succs)) {
+                if (node != nullptr) Node::destroy(node);
+                return sjtu::pair<iterator, bool>(iterator(succs[0]), false);
+            }
+            if (node == nullptr) node = Node::create(&value, top_level);
+            for (int level = 0; level < top_level; ++level) {
+                node->next[level].store(raw(succs[level]), std::memory_order_relaxed);
+            }
+            // linked at level 0 = in the list
+            uintptr_t expected = raw(succs[0]);
+            if (preds[0]->next[0].compare_exchange_strong(expected, raw(node), std::memory_order_acq_rel)) {
+                break;
+            }
+        }
+        current_size.fetch_add(1, std::memory_order_relaxed);
+
+        for (int level = 1; level < top_level; ++level) {
+            while (true) {
+                // point node to the current successor, unless an eraser has marked this level
+                uintptr_t next = node->next[level].load(std::memory_order_acquire);
+                if (marked(next)) {
+                    finish(node);
+                    return sjtu::pair<iterator, bool>(iterator(node), true);
+                }
+                if (next != raw(succs[level]) &&
+                    !node->next[level].compare_exchange_strong(next, raw(succs[level]), std::memory_order_acq_rel)) {
+                    continue;
+                }
+                uintptr_t expected = raw(succs[level]);
+                if (preds[level]->next[level].compare_exchange_strong(expected, raw(node), std::memory_order_acq_rel)) {
+                    break;
+                }
+                if (!find(value.first, preds, succs) || succs[0] != node) {
+                    // the node has been removed in the meantime
+                    finish(node);
+                    return sjtu::pair<iterator, bool>(iterator(node), true);
+                }
+            }
+        }
+        finish(node);
+        return sjtu::pair<iterator, bool>(iterator(node), true);
+    }
+
+    /**
+     * @brief remove the element with key
+     *
+     * @return the number of removed elements, 0 or 1
+     */
+    size_t erase(const Key &key) {
+        epochGuard guard;
+        Node *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+        if (!find(key, preds, succs)) {
+            return 0;
+        }
+        Node *node = succs[0];
+        for (int level = node->top_level - 1; level >= 1; --level) {
+            uintptr_t next = node->next[level].load(std::memory_order_acquire);
+            while (!marked(next)) {
+                node->next[level].compare_exchange_weak(next, mark(next), std::memory_order_acq_rel);
+            }
+        }
+        uintptr_t next = node->next[0].load(std::memory_order_acquire);
+        while (true) {
+            if (marked(next)) {
+                // another thread removed it first
+                return 0;
+            }
+            if (node->next[0].compare_exchange_strong(next, mark(next), std::memory_order_acq_rel)) {
+                current_size.fetch_sub(1, std::memory_order_relaxed);
+                find(key, preds, succs);
+                finish(node);
+                return 1;
+            }
+        }
+    }
+
+    void erase(iterator pos) {
+        if (pos.node == nullptr) {
+            throw sjtu::invalid_iterator();
+        }
+        erase(pos->first);
+    }
+
+    /**
+     * @brief The element with key, or end(). Hold an epochGuard to use the iterator.
+     */
+    iterator find(const Key &key) const {
+        epochGuard guard;
+        Node *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+        return find(key, preds, succs) ? iterator(succs[0]) : end();
+    }
+
+    /**
+     * @brief The first element with a key not less than key, the start of a range scan
+     */
+    iterator lower_bound(const Key &key) const {
+        epochGuard guard;
+        Node *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+        find(key, preds, succs);
+        return iterator(succs[0]);
+    }
+
+    size_t count(const Key &key) const {
+        epochGuard guard;
+        Node *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+        return find(key, preds, succs) ? 1 : 0;
+    }
+
+    iterator begin() const {
+        iterator it(head);
+        return ++it;
+    }
+
+    iterator end() const {
+        return iterator(nullptr);
+    }
+
+    /**
+     * @brief Visit the elements with keys in [low, high) in order, visit(const value_type &)
+     */
+    template<class Visitor>
+    void range(const Key &low, const Key &high, Visitor visit) const {
+        epochGuard guard;
+        for (iterator it = lower_bound(low); it != end() && less(it->first, high); ++it) {
+            visit(*it);
+        }
+    }
+};
+
+/**
+ * @brief The baseline: sjtu::map behind one mutex
+ */
+template<class Key, class T>
+class lockedMap {
+private:
+    mutable std::mutex mtx;
+    sjtu::map<Key, T> map;
+
+public:
+    void insert(const Key &key, const T &value) {
+        std::lock_guard<std::mutex> guard(mtx);
+        map.insert(sjtu::pair<const Key, T>(key, value));
+    }
+
+    void erase(const Key &key) {
+        std::lock_guard<std::mutex> guard(mtx);
+        auto it = map.find(key);
+        if (it != map.end()) map.erase(it);
+    }
+
+    bool contains(const Key &key) const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return map.find(key) != map.cend();
+    }
+};
+
+/**
+ * @brief every thread runs ops_per_thread random operations on keys in [0, key_range),
+ * read_percent of them lookups and the rest half inserts, half erases. Returns Mops/s.
+ */
+template<class Insert, class Erase, class Lookup>
+double mixedThroughput(size_t thread_num, size_t ops_per_thread, uint32_t key_range, int read_percent,
+                       Insert insert, Erase erase, Lookup lookup) {
+    std::atomic<size_t> found{0};// keeps the compiler from dropping the lookups
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < thread_num; ++t) {
+        pool.emplace_back([=, &found]() {
+            std::mt19937 gen(uint32_t(t + 1));
+            size_t hits = 0;
+            for (size_t i = 0; i < ops_per_thread; ++i) {
+                uint32_t key = gen() % key_range;
+                int r = gen() % 100;
+                if (r < read_percent) {
+                    hits += lookup(key);
+                } else if (r % 2 == 0) {
+                    insert(key);
+                } else {
+                    erase(key);
+                }
+            }
+            found.fetch_add(hits);
+        });
+    }
+    for (auto &thread : pool) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return thread_num * ops_per_thread / elapsed.count() / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "--- Concurrent Skip List Tests ---" << std::endl;
+    ConcurrentSkipList<int, std::string> list;
+    list.insert(ConcurrentSkipList<int, std::string>::value_type(3, "three"));
+    list.insert(ConcurrentSkipList<int, std::string>::value_type(1, "one"));
+    list.insert(ConcurrentSkipList<int, std::string>::value_type(2, "two"));
+    bool again = list.insert(ConcurrentSkipList<int, std::string>::value_type(2, "TWO")).second;
+    {
+        epochGuard guard;
+        std::cout << "In order:";
+        for (auto it = list.begin(); it != list.end(); ++it) {
+            std::cout << " " << it->first << "=" << it->second;
+        }
+        std::cout << ", insert 2 again: " << again << " (Expected: 1=one 2=two 3=three, 0)" << std::endl;
+    }
+    list.erase(2);
+    std::cout << "After erase(2): size " << list.size() << ", count(2) " << list.count(2) << " (Expected: 2 0)" << std::endl;
+
+    // every thread owns the keys k with k % threads == t: inserts all, erases the odd ones, range scans
+    {
+        const int threads = 4, per_thread = 50000;
+        ConcurrentSkipList<int, int> shared;
+        std::atomic<bool> scans_sorted{true};
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([&shared, &scans_sorted, t]() {
+                for (int i = 0; i < per_thread; ++i) {
+                    int key = i * threads + t;
+                    shared.insert(ConcurrentSkipList<int, int>::value_type(key, key));
+                    if (i % 2 == 1) shared.erase(key);
+                    if (i % 1000 == 0) {
+                        int last = -1;
+                        shared.range(key - 500, key + 500, [&last, &scans_sorted](const ConcurrentSkipList<int, int>::value_type &x) {
+                            if (x.first <= last) scans_sorted = false;
+                            last = x.first;
+                        });
+                    }
+                }
+            });
+        }
+        for (auto &thread : pool) {
+            thread.join();
+        }
+        bool pass = shared.size() == size_t(threads * per_thread / 2) && scans_sorted;
+        epochGuard guard;
+        int expected = 0;
+        for (auto it = shared.begin(); it != shared.end() && pass; ++it) {
+            // the survivors are i * threads + t with even i
+            while ((expected / threads) % 2 == 1) ++expected;
+            pass = it->first == expected && it->second == expected;
+            ++expected;
+        }
+        std::cout << "Concurrent insert / erase / range: " << (pass ? "PASS" : "FAIL") << std::endl;
+    }
+
+    // usage: ConcurrentSkipList [max threads] [operations per thread]
+    size_t max_threads = argc > 1 ? std::stoull(argv[1]) : std::max<unsigned>(1, std::thread::hardware_concurrency());
+    size_t ops = argc > 2 ? std::stoull(argv[2]) : 1000000;
+    const uint32_t key_range = 1000000;
+    for (int read_percent : {90, 50}) {
+        std::cout << "\n--- Throughput (Mops/s), " << read_percent << "% reads, " << key_range / 2
+                  << " keys, " << ops << " operations per thread ---" << std::endl;
+        for (size_t t = 1; t <= max_threads; t = (t * 2 > max_threads && t != max_threads) ? max_threads : t * 2) {
+            ConcurrentSkipList<uint32_t, uint32_t> skip;
+            lockedMap<uint32_t, uint32_t> locked;
+            for (uint32_t k = 0; k < key_range; k += 2) {
+                skip.insert(ConcurrentSkipList<uint32_t, uint32_t>::value_type(k, k));
+                locked.insert(k, k);
+            }
+            double skip_rate = mixedThroughput(
+                    t, ops, key_range, read_percent,
+                    [&skip](uint32_t k) { skip.insert(ConcurrentSkipList<uint32_t, uint32_t>::value_type(k, k)); },
+                    [&skip](uint32_t k) { skip.erase(k); },
+                    [&skip](uint32_t k) { return skip.count(k); });
+            double locked_rate = mixedThroughput(
+                    t, ops, key_range, read_percent,
+                    [&locked](uint32_t k) { locked.insert(k, k); },
+                    [&locked](uint32_t k) { locked.erase(k); },
+                    [&locked](uint32_t k) { return locked.contains(k); });
+            std::cout << t << " threads: skip list " << skip_rate << ", mutex + sjtu::map " << locked_rate << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,336 @@
+/*
+Interval tree (CLRS 14.3) on top of the Red-Black tree in RBT.cpp.
+The intervals are ordered by their low endpoint, and every node keeps the max high endpoint
+of its subtree, which RBT maintains through its rotations with the Augment policy.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#define BENCHMARK_NO_MAIN
+#include "RBT.cpp"
+#undef BENCHMARK_NO_MAIN
+
+/**
+ * @brief The closed interval [low, high], ordered by low and then by high
+ */
+template<class T>
+struct interval {
+    T low;
+    T high;
+
+    bool operator<(const interval &other) const {
+        return low < other.low || (low == other.low && high < other.high);
+    }
+
+    bool operator>(const interval &other) const {
+        return other < *this;
+    }
+
+    bool operator==(const interval &other) const {
+        return low == other.low && high == other.high;
+    }
+
+    bool operator!=(const interval &other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * @brief The value stored with an interval, plus the max high endpoint of the subtree
+ */
+template<class T, class Value>
+struct intervalNode {
+    Value value;
+    T max_high;
+};
+
+/**
+ * @brief The augmentation: max_high = max(high, max_high of the two children)
+ */
+struct maxEndpoint {
+    static const bool enabled = true;
+
+    template<class Data>
+    static void update(Data &data, const Data *left, const Data *right) {
+        auto max_high = data.key.high;
+        if (left != nullptr && max_high < left->other.max_high) max_high = left->other.max_high;
+        if (right != nullptr && max_high < right->other.max_high) max_high = right->other.max_high;
+        data.other.max_high = max_high;
+    }
+};
+
+/**
+ * @brief Interval tree: insert / remove in O(log n), and all the intervals overlapping [a, b]
+ * in O(min(n, (k + 1) log n)) for k results (CLRS exercise 14.3-4), not O(log n + k):
+ * an interval which starts before a and reaches into [a, b] keeps max_high >= a on every
+ * ancestor, so the walk can pass O(log n) nodes which do not overlap for each such result.
+ * Intervals which start inside [a, b] cost O(1) each.
+ * An interval is stored at most once, inserting the same [low, high] again changes nothing.
+ *
+ * @tparam T the endpoint type, e.g. a timestamp or an IPv4 address
+ * @tparam Value the payload of an interval
+ */
+template<class T, class Value>
+class IntervalTree {
+private:
+    RBT<interval<T>, intervalNode<T, Value>, maxEndpoint> tree;
+    size_t current_size = 0;
+
+public:
+    size_t size() const {
+        return current_size;
+    }
+
+    void insert(const T &low, const T &high, const Value &value) {
+        interval<T> key{low, high};
+        if (tree.find(key) != nullptr) {
+            return;
+        }
+        tree.insert(set<interval<T>, intervalNode<T, Value>>{key, intervalNode<T, Value>{value, high}});
+        ++current_size;
+    }
+
+    void remove(const T &low, const T &high) {
+        interval<T> key{low, high};
+        if (tree.find(key) == nullptr) {
+            return;
+        }
+        tree.remove(key);
+        --current_size;
+    }
+
+    /**
+     * @brief Visit every interval overlapping [a, b] in the order of the low endpoints.
+     * A subtree is skipped when its max high endpoint is below a, and the traversal stops
+     * at the first low endpoint above b.
+     *
+     * @param visit void(const interval<T> &, const Value &)
+     */
+    template<class Visitor>
+    void overlaps(const T &a, const T &b, Visitor visit) const {
+        tree.walk(
+                [&a](const set<interval<T>, intervalNode<T, Value>> &data) { return data.other.max_high < a; },
+                [&a, &b, &visit](const set<interval<T>, intervalNode<T, Value>> &data) {
+                    if (b < data.key.low) {
+                        return false;
+                    }
+                    if (!(data.key.high < a)) {
+                        visit(data.key, data.other.value);
+                    }
+                    return true;
+                });
+    }
+
+    /**
+     * @brief All the intervals overlapping [a, b]
+     */
+    std::vector<std::pair<interval<T>, Value>> overlaps(const T &a, const T &b) const {
+        std::vector<std::pair<interval<T>, Value>> result;
+        overlaps(a, b, [&result](const interval<T> &i, const Value &v) { result.emplace_back(i, v); });
+        return result;
+    }
+
+    /**
+     * @brief Visit every interval containing point
+     */
+    template<class Visitor>
+    void stab(const T &point, Visitor visit) const {
+        overlaps(point, point, visit);
+    }
+
+    std::vector<std::pair<interval<T>, Value>> stab(const T &point) const {
+        return overlaps(point, point);
+    }
+};
+
+/**
+ * @brief The sorted-vector approach: intervals sorted by low, a query scans the lows in
+ * [a - max_length, b], which is fast only while the intervals are short
+ */
+template<class T>
+class sortedIntervals {
+private:
+    std::vector<interval<T>> data;
+    T max_length = 0;
+
+public:
+    explicit sortedIntervals(std::vector<interval<T>> intervals) : data(std::move(intervals)) {
+        std::sort(data.begin(), data.end());
+        for (auto &i : data) {
+            max_length = std::max(max_length, i.high - i.low);
+        }
+    }
+
+    template<class Visitor>
+    void overlaps(const T &a, const T &b, Visitor visit) const {
+        // a - max_length would wrap around for an unsigned T
+        T start = a < std::numeric_limits<T>::lowest() + max_length ? std::numeric_limits<T>::lowest() : a - max_length;
+        auto it = std::lower_bound(data.begin(), data.end(), interval<T>{start, start});
+        for (; it != data.end() && !(b < it->low); ++it) {
+            if (!(it->high < a)) {
+                visit(*it);
+            }
+        }
+    }
+};
+
+/**
+ * @brief build the tree and the sorted vector over n random time ranges and time the queries
+ */
+void benchmark(size_t n, size_t queries) {
+    std::cout << "\n--- Benchmark: " << n << " intervals, " << queries << " queries ---" << std::endl;
+
+    // time ranges: mostly short sessions, a few long-running ones
+    const int64_t horizon = int64_t(1) << 40;
+    std::mt19937_64 gen64(2025);
+    std::vector<interval<int64_t>> intervals(n);
+    for (auto &x : intervals) {
+        x.low = gen64() % horizon;
+        int64_t length = (gen64() % 1000 == 0) ? gen64() % (horizon / 1000) : gen64() % (horizon / n * 4 + 1);
+        x.high = x.low + length;
+    }
+    std::vector<std::pair<int64_t, int64_t>> ranges(queries);
+    for (auto &q : ranges) {
+        q.first = gen64() % horizon;
+        q.second = q.first + gen64() % (horizon / n * 16 + 1);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    IntervalTree<int64_t, uint32_t> index;
+    for (size_t i = 0; i < n; ++i) {
+        index.insert(intervals[i].low, intervals[i].high, uint32_t(i));
+    }
+    auto built = std::chrono::high_resolution_clock::now();
+    size_t tree_hits = 0;
+    for (auto &q : ranges) {
+        index.overlaps(q.first, q.second, [&tree_hits](const interval<int64_t> &, uint32_t) { ++tree_hits; });
+    }
+    auto tree_end = std::chrono::high_resolution_clock::now();
+
+    sortedIntervals<int64_t> sorted(intervals);
+    auto sorted_built = std::chrono::high_resolution_clock::now();
+    size_t sorted_hits = 0;
+    for (auto &q : ranges) {
+        sorted.overlaps(q.first, q.second, [&sorted_hits](const interval<int64_t> &) { ++sorted_hits; });
+    }
+    auto sorted_end = std::chrono::high_resolution_clock::now();
+
+    // the linear scan is too slow for every query, run the first 100
+    size_t scan_queries = std::min<size_t>(queries, 100), scan_hits = 0, tree_hits_prefix = 0;
+    for (size_t i = 0; i < scan_queries; ++i) {
+        for (auto &x : intervals) {
+            scan_hits += !(x.high < ranges[i].first) && !(ranges[i].second < x.low);
+        }
+    }
+    auto scan_end = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < scan_queries; ++i) {
+        index.overlaps(ranges[i].first, ranges[i].second,
+                       [&tree_hits_prefix](const interval<int64_t> &, uint32_t) { ++tree_hits_prefix; });
+    }
+
+    std::chrono::duration<double, std::micro> build_time = built - start, tree_time = tree_end - built,
+                                                sort_time = sorted_built - tree_end,
+                                                sorted_time = sorted_end - sorted_built,
+                                                scan_time = scan_end - sorted_end;
+    std::cout << "Interval tree: build " << build_time.count() / 1e6 << " s, "
+              << tree_time.count() / queries << " us per query" << std::endl;
+    std::cout << "Sorted vector: build " << sort_time.count() / 1e6 << " s, "
+              << sorted_time.count() / queries << " us per query" << std::endl;
+    std::cout << "Linear scan: " << scan_time.count() / scan_queries << " us per query" << std::endl;
+    std::cout << "Average overlaps per query: " << double(tree_hits) / queries << std::endl;
+    std::cout << "Same results: "
+              << (tree_hits == sorted_hits && scan_hits == tree_hits_prefix && index.size() == n ? "PASS" : "FAIL")
+              << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "--- Interval Tree Tests ---" << std::endl;
+    IntervalTree<int, std::string> meetings;
+    meetings.insert(9, 10, "standup");
+    meetings.insert(13, 15, "review");
+    meetings.insert(10, 12, "design");
+    meetings.insert(14, 18, "offsite");
+    meetings.insert(8, 9, "breakfast");
+
+    std::cout << "Overlapping [11, 13]:";
+    meetings.overlaps(11, 13, [](const interval<int> &i, const std::string &name) {
+        std::cout << " " << name << "[" << i.low << ", " << i.high << "]";
+    });
+    std::cout << " (Expected: design[10, 12] review[13, 15])" << std::endl;
+
+    std::cout << "Stab 9:";
+    for (auto &item : meetings.stab(9)) {
+        std::cout << " " << item.second;
+    }
+    std::cout << " (Expected: breakfast standup)" << std::endl;
+
+    meetings.remove(10, 12);
+    std::cout << "After removing design, overlapping [11, 13]: " << meetings.overlaps(11, 13).size()
+              << " (Expected: 1)" << std::endl;
+
+    // random insertions, removals and queries against a linear scan
+    std::mt19937 gen(2025);
+    IntervalTree<int, int> checked;
+    std::vector<interval<int>> all;
+    bool pass = true;
+    for (int i = 0; i < 20000 && pass; ++i) {
+        int low = gen() % 10000, high = low + gen() % 200;
+        if (gen() % 3 != 0 || all.empty()) {
+            if (std::find(all.begin(), all.end(), interval<int>{low, high}) == all.end()) {
+                all.push_back(interval<int>{low, high});
+            }
+            checked.insert(low, high, i);
+        } else {
+            size_t victim = gen() % all.size();
+            checked.remove(all[victim].low, all[victim].high);
+            all.erase(all.begin() + victim);
+        }
+
+        // the intervals themselves, in the order of the low endpoints, so a wrong or repeated one fails
+        int a = gen() % 10000, b = a + gen() % 100;
+        std::vector<interval<int>> expected, found;
+        for (auto &x : all) {
+            if (!(x.high < a) && !(b < x.low)) {
+                expected.push_back(x);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        for (auto &item : checked.overlaps(a, b)) {
+            found.push_back(item.first);
+        }
+        pass = found == expected && checked.size() == all.size();
+    }
+    std::cout << "Random operations: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+    // IPv4 ranges near address 0, where a - max_length wraps around for uint32_t
+    IntervalTree<uint32_t, int> blocks;
+    std::vector<interval<uint32_t>> ranges{{0, 255}, {10, 20}, {100, 4000}, {3000, 3100}};
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        blocks.insert(ranges[i].low, ranges[i].high, int(i));
+    }
+    sortedIntervals<uint32_t> sorted_blocks(ranges);
+    std::vector<interval<uint32_t>> tree_found, sorted_found;
+    blocks.stab(15, [&tree_found](const interval<uint32_t> &i, int) { tree_found.push_back(i); });
+    sorted_blocks.overlaps(15, 15, [&sorted_found](const interval<uint32_t> &i) { sorted_found.push_back(i); });
+    std::cout << "Unsigned endpoints, stab 15: " << tree_found.size() << " and " << sorted_found.size()
+              << " (Expected: 2 and 2), " << (tree_found == sorted_found ? "PASS" : "FAIL") << std::endl;
+
+    // usage: IntervalTree [intervals] [queries]
+    size_t queries = argc > 2 ? std::stoull(argv[2]) : 100000;
+    if (argc > 1) {
+        benchmark(std::stoull(argv[1]), queries);
+    } else {
+        // the sorted vector scans about n / 1000 lows per query, the tree pays a path per long result
+        for (size_t n : {1000000, 10000000}) {
+            benchmark(n, queries);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,339 @@
+/*
+A learned index over an immutable sorted 1-based array of set<KEY, OTHER> (PGM-index style):
+the position of a key is predicted by a piecewise-linear model whose error is bounded by epsilon,
+so a lookup is a prediction and a binary search of 2 * epsilon + 2 elements around it.
+The segments are fitted in one pass with the shrinking cone, and the first keys of the segments
+are indexed by the same kind of model, level after level, until one segment is left.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#define BENCHMARK_NO_MAIN
+#include "Set.cpp"
+#undef BENCHMARK_NO_MAIN
+
+/**
+ * @brief Piecewise-linear learned index, the keys must be arithmetic and strictly increasing
+ *
+ * @tparam KEY
+ * @tparam OTHER
+ */
+template<class KEY, class OTHER>
+class LearnedIndex {
+    static_assert(std::is_arithmetic<KEY>::value, "the model needs arithmetic keys");
+
+    //predicts position + slope * (x - key) for the keys from key on, up to the next segment
+    struct segment {
+        KEY key;
+        int position;
+        double slope;
+    };
+
+    //the error bound of the levels above the first one, which are tiny
+    static const int UPPER_EPSILON = 8;
+    static const int BATCH = 16;
+    static const int LINE_ELEMENTS = sizeof(set<KEY, OTHER>) < 64 ? int(64 / sizeof(set<KEY, OTHER>)) : 1;
+
+private:
+    set<KEY, OTHER> *data = nullptr;
+    int size = 0;
+    int epsilon = 0;
+    //levels[0] models the positions in data, levels[l] the positions in levels[l - 1],
+    //levels.back() has one segment
+    std::vector<std::vector<segment>> levels;
+    std::vector<int> errors;//the max error measured on every level, the search radius
+
+    /**
+     * @brief The shrinking cone: a segment starts at its first point and keeps the range of
+     * slopes that stay within epsilon of all its points, it ends when the range becomes empty
+     */
+    template<class KeyAt>
+    static void fit(KeyAt keyAt, int n, int base, int epsilon, std::vector<segment> &out) {
+        out.clear();
+        int i = 0;
+        while (i < n) {
+            int start = i;
+            KEY first = keyAt(i++);
+            double low = -std::numeric_limits<double>::infinity(), high = std::numeric_limits<double>::infinity();
+            for (; i < n; ++i) {
+                double dx = double(keyAt(i)) - double(first), dy = i - start;
+                double l = (dy - epsilon) / dx, h = (dy + epsilon) / dx;
+                if (l > high || h < low) break;
+                low = std::max(low, l);
+                high = std::min(high, h);
+            }
+            //a slope of 0 is in the range whenever the middle is negative, and keeps predictions monotone
+            double slope = i - start == 1 ? 0 : std::max(0.0, (low + high) / 2);
+            out.push_back(segment{first, base + start, slope});
+        }
+    }
+
+    /**
+     * @brief The first index in [low, high) whose item is not before x, high if there is none.
+     * The halving compiles to conditional moves: without mispredicted branches the CPU runs ahead
+     * into the next lookups, so their cache misses overlap.
+     */
+    template<class Item, class Before>
+    static int searchWindow(const Item *items, int low, int high, Before before) {
+        if (low >= high) return low;
+        const Item *base = items + low;
+        int length = high - low;
+        while (length > 1) {
+            int half = length / 2;
+            base = before(base[half - 1]) ? base + half : base;
+            length -= half;
+        }
+        return int(base - items) + (before(*base) ? 1 : 0);
+    }
+
+    static double predict(const segment &s, const KEY &x) {
+        return s.position + s.slope * (double(x) - double(s.key));
+    }
+
+    /**
+     * @brief The range [low, high) of data holding the lower bound of x, or its end high
+     */
+    void window(const KEY &x, int &low, int &high) const {
+        if (size == 0 || !(data[1].key < x)) {
+            low = high = 1;
+            return;
+        }
+
+        //going down, s is the segment of level l holding the last key <= x
+        int s = 0;
+        for (int l = int(levels.size()) - 1; l > 0; --l) {
+            const std::vector<segment> &below = levels[l - 1];
+            const segment &model = levels[l][s];
+            int end = s + 1 < int(levels[l].size()) ? levels[l][s + 1].position : int(below.size());
+            //past the last key of the segment the line is extrapolated, the answer is at most end
+            double p = std::min(std::max(predict(model, x), double(model.position)), double(end));
+            //the first key > x is within the error of the prediction, and inside the segment,
+            //p >= 0 so int(p) is its floor
+            int first = std::max(model.position, int(p) - errors[l] - 1);
+            int last = std::min(end, int(p) + errors[l] + 2);
+            s = searchWindow(below.data(), first, last, [&x](const segment &t) { return !(x < t.key); }) - 1;
+        }
+
+        const segment &model = levels[0][s];
+        int end = s + 1 < int(levels[0].size()) ? levels[0][s + 1].position : size + 1;
+        double p = std::min(std::max(predict(model, x), double(model.position)), double(end));
+        low = std::max(model.position, int(p) - errors[0]);
+        high = std::min(end, int(p) + errors[0] + 2);
+    }
+
+    //the max |prediction - position| over the keys of one level
+    template<class KeyAt>
+    static int measure(KeyAt keyAt, int n, int base, const std::vector<segment> &model) {
+        double worst = 0;
+        for (size_t s = 0; s < model.size(); ++s) {
+            int end = s + 1 < model.size() ? model[s + 1].position : base + n;
+            for (int position = model[s].position; position < end; ++position) {
+                worst = std::max(worst, std::fabs(predict(model[s], keyAt(position - base)) - position));
+            }
+        }
+        return int(std::ceil(worst));
+    }
+
+public:
+    LearnedIndex() = default;
+
+    LearnedIndex(set<KEY, OTHER> *data_, int size_, int epsilon_ = 64) {
+        build(data_, size_, epsilon_);
+    }
+
+    /**
+     * @brief Build the index of the ordered set data[1..size], O(size). The array is not copied
+     * and must not change while the index is used.
+     */
+    void build(set<KEY, OTHER> *data_, int size_, int epsilon_ = 64) {
+        data = data_;
+        size = size_;
+        epsilon = epsilon_;
+        levels.clear();
+        errors.clear();
+        if (size == 0) return;
+
+        levels.emplace_back();
+        auto dataKey = [this](int i) { return data[1 + i].key; };
+        fit(dataKey, size, 1, epsilon, levels[0]);
+        errors.push_back(measure(dataKey, size, 1, levels[0]));
+        while (levels.back().size() > 1) {
+            const std::vector<segment> &below = levels.back();
+            std::vector<segment> model;
+            auto segmentKey = [&below](int i) { return below[i].key; };
+            fit(segmentKey, int(below.size()), 0, UPPER_EPSILON, model);
+            errors.push_back(measure(segmentKey, int(below.size()), 0, model));
+            levels.push_back(std::move(model));
+        }
+    }
+
+    /**
+     * @brief The index of the first element with key >= x, size + 1 if there is none
+     */
+    int lower_bound(const KEY &x) const {
+        int low, high;
+        window(x, low, high);
+        return searchWindow(data, low, high, [&x](const set<KEY, OTHER> &a) { return a.key < x; });
+    }
+
+    /**
+     * @brief lower_bound of xs[0..count) into result. The windows of BATCH lookups are found first
+     * and their cache lines prefetched, then searched, so the misses of the lookups overlap.
+     */
+    void lower_bound(const KEY *xs, int count, int *result) const {
+        int low[BATCH], high[BATCH];
+        for (int begin = 0; begin < count; begin += BATCH) {
+            int batch = count - begin < BATCH ? count - begin : BATCH;
+            for (int j = 0; j < batch; ++j) {
+                window(xs[begin + j], low[j], high[j]);
+                //at most 16 cache lines, around the middle of the window
+                int middle = low[j] + (high[j] - low[j]) / 2;
+                const set<KEY, OTHER> *first = data + std::max(low[j], middle - 8 * LINE_ELEMENTS);
+                const set<KEY, OTHER> *last = data + std::min(high[j], middle + 8 * LINE_ELEMENTS);
+                for (const set<KEY, OTHER> *line = first; line < last; line += LINE_ELEMENTS) __builtin_prefetch(line);
+            }
+            for (int j = 0; j < batch; ++j) {
+                const KEY &x = xs[begin + j];
+                result[begin + j] = searchWindow(data, low[j], high[j], [&x](const set<KEY, OTHER> &a) { return a.key < x; });
+            }
+        }
+    }
+
+    /**
+     * @brief The index of the element with key x, 0 for finding nothing
+     */
+    int find(const KEY &x) const {
+        int index = lower_bound(x);
+        return (index <= size && data[index].key == x) ? index : 0;
+    }
+
+    /**
+     * @brief The max error of the bottom level, at most epsilon up to rounding
+     */
+    int maxError() const {
+        return errors.empty() ? 0 : errors[0];
+    }
+
+    size_t segments() const {
+        size_t count = 0;
+        for (auto &level : levels) count += level.size();
+        return count;
+    }
+
+    int height() const {
+        return int(levels.size());
+    }
+
+    /**
+     * @brief The bytes to store the model: the segments, the error of every level, epsilon and size
+     */
+    size_t serializedSize() const {
+        return segments() * sizeof(segment) + errors.size() * sizeof(int) + 2 * sizeof(int);
+    }
+};
+
+int main(int argc, char *argv[]) {
+    std::cout << "--- Learned Index Tests ---" << std::endl;
+    set<int, std::string> words[] = {{0, ""}, {2, "two"}, {3, "three"}, {5, "five"}, {7, "seven"}, {11, "eleven"}};
+    LearnedIndex<int, std::string> small(words, 5, 1);
+    std::cout << "find(7): " << words[small.find(7)].other << ", find(4): " << small.find(4)
+              << ", lower_bound(4): " << small.lower_bound(4) << ", lower_bound(12): " << small.lower_bound(12)
+              << " (Expected: seven, 0, 3, 6)" << std::endl;
+
+    //random gaps, from smooth to bursty, and several epsilons against std::lower_bound
+    std::mt19937 gen(2025);
+    bool pass = true;
+    for (int round = 0; round < 300 && pass; ++round) {
+        int n = 1 + int(gen() % 5000);
+        std::vector<set<int, int>> data(n + 1);
+        int key = -int(gen() % 1000);
+        for (int i = 1; i <= n; ++i) {
+            int gap = round % 3 == 0 ? 1 : (round % 3 == 1 ? 1 + int(gen() % 30) : (gen() % 10 ? 1 : 1 + int(gen() % 100000)));
+            data[i] = set<int, int>{key += gap, i};
+        }
+        int epsilon = 1 << (gen() % 8);
+        LearnedIndex<int, int> index(data.data(), n, epsilon);
+        pass = index.maxError() <= epsilon + 1;
+        for (int q = 0; q < 300 && pass; ++q) {
+            int x = q % 2 ? data[1 + gen() % n].key + int(gen() % 3) - 1 : data[1].key - 5 + int(gen() % unsigned(key - data[1].key + 10));
+            int expected = int(std::lower_bound(data.begin() + 1, data.end(), x, [](const set<int, int> &a, int b) { return a.key < b; }) - data.begin());
+            int batched;
+            index.lower_bound(&x, 1, &batched);
+            pass = index.lower_bound(x) == expected && batched == expected && index.find(x) == binarySearch(data.data(), n, x);
+        }
+    }
+    std::cout << "Random keys: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+    // usage: LearnedIndex [keys] [queries]
+    int n = argc > 1 ? std::stoi(argv[1]) : 100000000;
+    int queries = argc > 2 ? std::stoi(argv[2]) : 10000000;
+    typedef std::chrono::high_resolution_clock clock;
+    const char *distributions[] = {"smooth (gaps 1..40)", "bursty (90% gaps 1..4, 10% gaps 1..200)"};
+    for (int d = 0; d < 2; ++d) {
+        std::cout << "\n--- Benchmark: " << n << " " << distributions[d] << " int keys, " << queries << " lookups ---" << std::endl;
+        std::mt19937 gen_keys(2025);
+        std::vector<set<int, int>> data(n + 1);
+        long long key = 0;
+        for (int i = 1; i <= n; ++i) {
+            key += d == 0 ? 1 + gen_keys() % 40 : (gen_keys() % 10 ? 1 + gen_keys() % 4 : 1 + gen_keys() % 200);
+            data[i] = set<int, int>{int(key), i};
+        }
+        std::vector<int> xs(queries);
+        for (int &x : xs) x = gen_keys() % 2 ? data[1 + gen_keys() % n].key : int(gen_keys() % (unsigned long long) (key + 1));
+
+        long long expected = -1;
+        bool same = true;
+        auto run = [&](const char *name, auto lookup) {
+            auto start = clock::now();
+            long long sum = 0;
+            for (int x : xs) sum += lookup(x);
+            double seconds = std::chrono::duration<double>(clock::now() - start).count();
+            std::cout << name << ": " << queries / seconds / 1e6 << " M lookups/s" << std::endl;
+            if (expected == -1) expected = sum;
+            same = same && sum == expected;
+        };
+
+        run("binarySearch", [&data, n](int x) { return binarySearch(data.data(), n, x); });
+        run("interpolationSearch", [&data, n](int x) { return interpolationSearch(data.data(), n, x); });
+        {
+            BlockIndex<int, int> block(data.data(), n);
+            run("BlockIndex", [&block](int x) { return block.find(x); });
+        }
+        std::vector<int> lower(queries);
+        {
+            EytzingerSet<int, int> eytzinger(data.data(), n);
+            run("EytzingerSet", [&eytzinger](int x) { return eytzinger.find(x); });
+            auto start = clock::now();
+            eytzinger.lower_bound(xs.data(), queries, lower.data());
+            double seconds = std::chrono::duration<double>(clock::now() - start).count();
+            std::cout << "EytzingerSet batched: " << queries / seconds / 1e6 << " M lookups/s" << std::endl;
+        }
+        for (int epsilon : {32, 128, 512}) {
+            auto start = clock::now();
+            LearnedIndex<int, int> index(data.data(), n, epsilon);
+            double build_time = std::chrono::duration<double>(clock::now() - start).count();
+            std::cout << "LearnedIndex epsilon " << epsilon << ": " << index.segments() << " segments in "
+                      << index.height() << " levels, " << index.serializedSize() / 1024.0 << " KB, max error "
+                      << index.maxError() << ", built in " << build_time << " s" << std::endl;
+            std::string name = "LearnedIndex epsilon " + std::to_string(epsilon);
+            run(name.c_str(), [&index](int x) { return index.find(x); });
+            start = clock::now();
+            index.lower_bound(xs.data(), queries, lower.data());
+            double seconds = std::chrono::duration<double>(clock::now() - start).count();
+            long long sum = 0;
+            for (int i = 0; i < queries; ++i) sum += (lower[i] <= n && data[lower[i]].key == xs[i]) ? lower[i] : 0;
+            std::cout << name << " batched: " << queries / seconds / 1e6 << " M lookups/s" << std::endl;
+            same = same && sum == expected;
+        }
+        std::cout << "Same results: " << (same ? "PASS" : "FAIL") << std::endl;
+    }
+    return 0;
+}
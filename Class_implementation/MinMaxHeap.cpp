@@ -0,0 +1,370 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define BENCHMARK_NO_MAIN
+#include "heap.cpp"
+#undef BENCHMARK_NO_MAIN
+
+/**
+ * @brief Min-max heap (Atkinson et al., 1986), a double-ended priority queue.
+ * Same layout as PriorityQueue in heap.cpp: a 1-based array where array[0] is unused
+ * and the children of i are 2i and 2i + 1.
+ * Nodes on even levels (the root is level 0) are smaller than all their descendants,
+ * nodes on odd levels are greater than all their descendants, so the minimum is
+ * array[1] and the maximum is one of array[2], array[3].
+ * @tparam T Must support operator<.
+ */
+template<class T>
+class MinMaxHeap {
+private:
+    size_t current_size;
+    T *array;
+    size_t max_size;// capacity of array, including the unused array[0]
+
+    void doublespace() {
+        T *tmp = array;
+        max_size *= 2;
+        array = new T[max_size];
+        for (size_t i = 1; i <= current_size; ++i) {
+            array[i] = tmp[i];
+        }
+        delete[] tmp;
+    }
+
+    static bool minLevel(size_t i) {
+        size_t level = 0;
+        while (i > 1) {
+            i >>= 1;
+            ++level;
+        }
+        return level % 2 == 0;
+    }
+
+    // isMin: a comes before b on a min level, otherwise on a max level
+    template<bool isMin>
+    static bool before(const T &a, const T &b) {
+        return isMin ? a < b : b < a;
+    }
+
+    /**
+     * @brief move the value in hole up through its grandparents of the same kind of level
+     */
+    template<bool isMin>
+    void percolateUpLevel(size_t hole, const T &value) {
+        while (hole >= 4 && before<isMin>(value, array[hole / 4])) {
+            array[hole] = array[hole / 4];
+            hole /= 4;
+        }
+        array[hole] = value;
+    }
+
+    void percolateUp(size_t hole, const T &value) {
+        if (hole == 1) {
+            array[hole] = value;
+            return;
+        }
+
+        size_t parent = hole / 2;
+        if (minLevel(hole)) {
+            if (array[parent] < value) {
+                // larger than its max parent, belongs to the max levels
+                array[hole] = array[parent];
+                percolateUpLevel<false>(parent, value);
+            } else {
+                percolateUpLevel<true>(hole, value);
+            }
+        } else {
+            if (value < array[parent]) {
+                array[hole] = array[parent];
+                percolateUpLevel<true>(parent, value);
+            } else {
+                percolateUpLevel<false>(hole, value);
+            }
+        }
+    }
+
+    /**
+     * @brief restore the heap below hole, which is on a min level (isMin) or a max level
+     */
+    template<bool isMin>
+    void percolateDown(size_t hole) {
+        T tmp = array[hole];
+        while (hole * 2 <= current_size) {
+            // the best one in the children and the grandchildren
+            size_t best = hole * 2;
+            if (best + 1 <= current_size && before<isMin>(array[best + 1], array[best])) {
+                best = best + 1;
+            }
+            for (size_t g = hole * 4; g <= hole * 4 + 3 && g <= current_size; ++g) {
+                if (before<isMin>(array[g], array[best])) {
+                    best = g;
+                }
+            }
+
+            if (!before<isMin>(array[best], tmp)) {
+                break;
+            }
+
+            array[hole] = array[best];
+            if (best < hole * 4) {
+                // a child, which is a leaf of the other kind of level
+                hole = best;
+                break;
+            }
+
+            // a grandchild, tmp may now violate the order with its parent on the other level
+            hole = best;
+            if (before<isMin>(array[hole / 2], tmp)) {
+                std::swap(tmp, array[hole / 2]);
+            }
+        }
+        array[hole] = tmp;
+    }
+
+    size_t maxIndex() const {
+        if (current_size == 1) {
+            return 1;
+        }
+        if (current_size == 2 || array[3] < array[2]) {
+            return 2;
+        }
+        return 3;
+    }
+
+public:
+    explicit MinMaxHeap(size_t capacity = 100) : current_size(0), max_size(capacity + 1) {
+        if (max_size < 2) max_size = 2;
+        array = new T[max_size];
+    }
+
+    ~MinMaxHeap() {
+        delete[] array;
+    }
+
+    MinMaxHeap(const MinMaxHeap &other) : current_size(other.current_size), max_size(other.max_size) {
+        array = new T[max_size];
+        for (size_t i = 1; i <= current_size; ++i) {
+            array[i] = other.array[i];
+        }
+    }
+
+    MinMaxHeap &operator=(const MinMaxHeap &other) {
+        if (this != &other) {
+            MinMaxHeap tmp(other);
+            std::swap(current_size, tmp.current_size);
+            std::swap(max_size, tmp.max_size);
+            std::swap(array, tmp.array);
+        }
+        return *this;
+    }
+
+    bool empty() const {
+        return current_size == 0;
+    }
+
+    size_t size() const {
+        return current_size;
+    }
+
+    void push(const T &x) {
+        if (current_size == max_size - 1) {
+            doublespace();
+        }
+        ++current_size;
+        percolateUp(current_size, x);
+    }
+
+    const T &min() const {
+        if (empty()) {
+            throw std::underflow_error("Min-max heap is empty");
+        }
+        return array[1];
+    }
+
+    const T &max() const {
+        if (empty()) {
+            throw std::underflow_error("Min-max heap is empty");
+        }
+        return array[maxIndex()];
+    }
+
+    T pop_min() {
+        if (empty()) {
+            throw std::underflow_error("Min-max heap is empty");
+        }
+        T min_item = array[1];
+        array[1] = array[current_size--];
+        if (current_size > 1) {
+            percolateDown<true>(1);
+        }
+        return min_item;
+    }
+
+    T pop_max() {
+        if (empty()) {
+            throw std::underflow_error("Min-max heap is empty");
+        }
+        size_t hole = maxIndex();
+        T max_item = array[hole];
+        array[hole] = array[current_size--];
+        if (hole <= current_size) {
+            percolateDown<false>(hole);
+        }
+        return max_item;
+    }
+};
+
+/**
+ * @brief The old way: two PriorityQueues from heap.cpp over the same elements, one ordered
+ * by score and one by reversed score. An element popped from one heap is marked dead
+ * and skipped lazily in the other one.
+ */
+class TwoHeapTopN {
+private:
+    typedef std::pair<int, size_t> item;// score, id
+
+    struct reversed {
+        item x;
+        bool operator<(const reversed &other) const { return other.x < x; }
+    };
+
+    PriorityQueue<item> min_heap;
+    PriorityQueue<reversed> max_heap;
+    std::vector<bool> alive;
+    size_t current_size = 0;
+
+    void cleanMin() {
+        while (!min_heap.empty() && !alive[min_heap.getHead().second]) {
+            min_heap.deQueue();
+        }
+    }
+
+    void cleanMax() {
+        while (!max_heap.empty() && !alive[max_heap.getHead().x.second]) {
+            max_heap.deQueue();
+        }
+    }
+
+public:
+    size_t size() const { return current_size; }
+
+    void push(int score) {
+        min_heap.enQueue(item(score, alive.size()));
+        max_heap.enQueue(reversed{item(score, alive.size())});
+        alive.push_back(true);
+        ++current_size;
+    }
+
+    int pop_min() {
+        cleanMin();
+        item x = min_heap.deQueue();
+        alive[x.second] = false;
+        --current_size;
+        return x.first;
+    }
+
+    int pop_max() {
+        cleanMax();
+        item x = max_heap.deQueue().x;
+        alive[x.second] = false;
+        --current_size;
+        return x.first;
+    }
+};
+
+/**
+ * @brief keep the top n scores of the stream, serve (pop the maximum) every serve_gap items
+ */
+template<class Container>
+long long topNWorkload(Container &c, const std::vector<int> &stream, size_t n, size_t serve_gap) {
+    long long served = 0;
+    for (size_t i = 0; i < stream.size(); ++i) {
+        c.push(stream[i]);
+        if (c.size() > n) {
+            c.pop_min();
+        }
+        if (i % serve_gap == 0) {
+            served += c.pop_max();
+        }
+    }
+    return served;
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "--- Min-Max Heap Tests ---" << std::endl;
+    MinMaxHeap<int> heap(3);
+    int data[] = {30, 10, 50, 20, 40, 5, 25, 45, 15, 35};
+    for (int x : data) {
+        heap.push(x);
+    }
+    std::cout << "min: " << heap.min() << ", max: " << heap.max() << std::endl;// Expected: 5 50
+    std::cout << "pop_max: " << heap.pop_max() << ", pop_min: " << heap.pop_min() << std::endl;
+    std::cout << "Remaining from both ends:";
+    while (!heap.empty()) {
+        std::cout << " " << heap.pop_min();
+        if (!heap.empty()) std::cout << " " << heap.pop_max();
+    }
+    std::cout << std::endl;// Expected: 10 45 15 40 20 35 25 30
+
+    try {
+        heap.pop_max();
+    } catch (const std::underflow_error &e) {
+        std::cout << "Caught expected exception: " << e.what() << std::endl;
+    }
+
+    // random operations against a sorted reference
+    std::mt19937 gen(2025);
+    std::vector<int> sorted;
+    MinMaxHeap<int> checked;
+    bool pass = true;
+    for (int i = 0; i < 200000 && pass; ++i) {
+        int op = gen() % 4;
+        if (op < 2 || sorted.empty()) {
+            int x = gen() % 1000;
+            checked.push(x);
+            sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), x), x);
+        } else if (op == 2) {
+            pass = checked.pop_min() == sorted.front();
+            sorted.erase(sorted.begin());
+        } else {
+            pass = checked.pop_max() == sorted.back();
+            sorted.pop_back();
+        }
+        if (pass && !sorted.empty()) {
+            pass = checked.min() == sorted.front() && checked.max() == sorted.back();
+        }
+    }
+    std::cout << "Random operations: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+    // usage: MinMaxHeap [stream length] [n]
+    size_t stream_len = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    size_t n = argc > 2 ? std::stoull(argv[2]) : 10000;
+    std::cout << "\n--- Benchmark: top " << n << " of " << stream_len << " scores, serve every 4th ---" << std::endl;
+    std::vector<int> stream(stream_len);
+    std::uniform_int_distribution<int> dis(1, 1000000000);
+    for (auto &x : stream) {
+        x = dis(gen);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    MinMaxHeap<int> mmh;
+    long long served_mmh = topNWorkload(mmh, stream, n, 4);
+    auto middle = std::chrono::high_resolution_clock::now();
+    TwoHeapTopN two;
+    long long served_two = topNWorkload(two, stream, n, 4);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double> mmh_time = middle - start;
+    std::chrono::duration<double> two_time = end - middle;
+    std::cout << "Min-max heap: " << mmh_time.count() * 1000 << " ms" << std::endl;
+    std::cout << "Two heaps with lazy deletion: " << two_time.count() * 1000 << " ms" << std::endl;
+    std::cout << "Same result: " << (served_mmh == served_two ? "PASS" : "FAIL") << std::endl;
+    return 0;
+}
@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#define BENCHMARK_NO_MAIN
+#include "heap.cpp"
+#undef BENCHMARK_NO_MAIN
+
+/**
+ * @brief per-thread xorshift generator for choosing queues, much cheaper than std::mt19937
+ */
+inline uint64_t fastRandom() {
+    thread_local uint64_t state = std::hash<std::thread::id>()(std::this_thread::get_id()) * 0x9E3779B97F4A7C15ull + 1;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+/**
+ * @brief Relaxed concurrent priority queue (MultiQueue, Rihani et al. 2015).
+ * c * P sequential PriorityQueues, each protected by its own spinlock.
+ * push() inserts into a random queue, pop() looks at the heads of two random queues
+ * and removes the smaller one. The popped element is not always the global minimum,
+ * but its expected rank error is O(c * P), while no lock is shared by all threads.
+ * The head of every queue is cached in an atomic, so comparing two queues takes no lock.
+ * @tparam T Must be trivially copyable (it is stored in std::atomic) and support operator<.
+ */
+template<class T>
+class MultiQueue {
+    static_assert(std::is_trivially_copyable<T>::value, "MultiQueue needs a trivially copyable T");
+
+private:
+    struct alignas(64) subQueue {
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        std::atomic<bool> nonempty{false};
+        std::atomic<T> head{};
+        PriorityQueue<T> heap;
+    };
+
+    size_t queue_num;
+    subQueue *queues;
+    std::atomic<long long> current_size{0};
+
+    bool tryLock(subQueue &q) {
+        return !q.lock.test_and_set(std::memory_order_acquire);
+    }
+
+    void unlock(subQueue &q) {
+        q.lock.clear(std::memory_order_release);
+    }
+
+    // refresh the cached head, called with the lock held
+    void refresh(subQueue &q) {
+        if (q.heap.empty()) {
+            q.nonempty.store(false, std::memory_order_relaxed);
+        } else {
+            q.head.store(q.heap.getHead(), std::memory_order_relaxed);
+            q.nonempty.store(true, std::memory_order_release);
+        }
+    }
+
+public:
+    /**
+     * @brief Construct a new MultiQueue object
+     *
+     * @param thread_num the number of threads P using the queue
+     * @param c queues per thread, usually 2 ~ 4
+     */
+    explicit MultiQueue(size_t thread_num, size_t c = 2) : queue_num(std::max<size_t>(2, thread_num * c)) {
+        queues = new subQueue[queue_num];
+    }
+
+    ~MultiQueue() {
+        delete[] queues;
+    }
+
+    MultiQueue(const MultiQueue &) = delete;
+    MultiQueue &operator=(const MultiQueue &) = delete;
+
+    /**
+     * @brief approximate number of elements, exact when no operation is running
+     */
+    size_t size() const {
+        long long n = current_size.load(std::memory_order_relaxed);
+        return n < 0 ? 0 : n;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    void push(const T &x) {
+        while (true) {
+            subQueue &q = queues[fastRandom() % queue_num];
+            if (!tryLock(q)) {
+                // somebody is using it, just try another one
+                continue;
+            }
+            q.heap.enQueue(x);
+            refresh(q);
+            unlock(q);
+            current_size.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    /**
+     * @brief remove the smaller head of two random queues
+     *
+     * @param x the removed element
+     * @return false if every queue is empty
+     */
+    bool pop(T &x) {
+        size_t misses = 0;
+        while (true) {
+            size_t i = fastRandom() % queue_num, j = fastRandom() % queue_num;
+            bool has_i = queues[i].nonempty.load(std::memory_order_acquire);
+            bool has_j = queues[j].nonempty.load(std::memory_order_acquire);
+            if (!has_i && !has_j) {
+                if (++misses >= queue_num) {
+                    // the queue may be (almost) empty, scan all of them once
+                    if (!popAny(x)) return false;
+                    return true;
+                }
+                continue;
+            }
+
+            size_t best = i;
+            if (!has_i || (has_j && queues[j].head.load(std::memory_order_relaxed) < queues[i].head.load(std::memory_order_relaxed))) {
+                best = j;
+            }
+
+            subQueue &q = queues[best];
+            if (!tryLock(q)) {
+                continue;
+            }
+            if (q.heap.empty()) {
+                unlock(q);
+                continue;
+            }
+            x = q.heap.deQueue();
+            refresh(q);
+            unlock(q);
+            current_size.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+private:
+    bool popAny(T &x) {
+        for (size_t i = 0; i < queue_num; ++i) {
+            subQueue &q = queues[i];
+            while (!tryLock(q)) {
+                std::this_thread::yield();
+            }
+            if (!q.heap.empty()) {
+                x = q.heap.deQueue();
+                refresh(q);
+                unlock(q);
+                current_size.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+            unlock(q);
+        }
+        return false;
+    }
+};
+
+/**
+ * @brief The baseline: a single PriorityQueue behind one mutex
+ */
+template<class T>
+class LockedQueue {
+private:
+    std::mutex mtx;
+    PriorityQueue<T> heap;
+
+public:
+    void push(const T &x) {
+        std::lock_guard<std::mutex> guard(mtx);
+        heap.enQueue(x);
+    }
+
+    bool pop(T &x) {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (heap.empty()) {
+            return false;
+        }
+        x = heap.deQueue();
+        return true;
+    }
+};
+
+/**
+ * @brief Rank error statistics of a relaxed priority queue
+ */
+struct rankErrorStats {
+    double mean;
+    size_t max;
+};
+
+/**
+ * @brief Measure the rank error of pop(): the number of elements in the queue which are
+ * smaller than the popped one. Single threaded, keys are in [0, key_range), ranks are
+ * counted with a Fenwick tree.
+ */
+template<class Queue>
+rankErrorStats measureRankError(Queue &queue, size_t prefill, size_t ops, uint32_t key_range = 1 << 20) {
+    std::vector<size_t> tree(key_range + 1, 0);
+    auto add = [&](uint32_t key, long delta) {
+        for (size_t i = key + 1; i <= key_range; i += i & (~i + 1)) tree[i] += delta;
+    };
+    auto smaller = [&](uint32_t key) {
+        size_t sum = 0;
+        for (size_t i = key; i > 0; i -= i & (~i + 1)) sum += tree[i];
+        return sum;
+    };
+
+    std::mt19937 gen(2025);
+    for (size_t i = 0; i < prefill; ++i) {
+        uint32_t key = gen() % key_range;
+        queue.push(key);
+        add(key, 1);
+    }
+
+    rankErrorStats stats{0, 0};
+    size_t pops = 0;
+    for (size_t i = 0; i < ops; ++i) {
+        uint32_t key;
+        if (!queue.pop(key)) break;
+        size_t rank = smaller(key);
+        add(key, -1);
+        stats.mean += rank;
+        stats.max = std::max(stats.max, rank);
+        ++pops;
+
+        key = gen() % key_range;
+        queue.push(key);
+        add(key, 1);
+    }
+    if (pops > 0) stats.mean /= pops;
+    return stats;
+}
+
+/**
+ * @brief every thread alternates push and pop, returns million operations per second
+ */
+template<class Queue>
+double throughput(Queue &queue, size_t thread_num, size_t prefill, size_t ops_per_thread) {
+    std::mt19937 gen(7);
+    for (size_t i = 0; i < prefill; ++i) {
+        queue.push(static_cast<uint32_t>(gen()));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < thread_num; ++t) {
+        pool.emplace_back([&queue, t, ops_per_thread]() {
+            std::mt19937 local(t);
+            uint32_t x;
+            for (size_t i = 0; i < ops_per_thread; i += 2) {
+                queue.push(static_cast<uint32_t>(local()));
+                queue.pop(x);
+            }
+        });
+    }
+    for (auto &thread : pool) {
+        thread.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+    return thread_num * ops_per_thread / elapsed.count() / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "--- MultiQueue Tests ---" << std::endl;
+    MultiQueue<uint32_t> mq(4);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        mq.push(i);
+    }
+    std::vector<bool> seen(1000, false);
+    uint32_t x;
+    size_t popped = 0;
+    while (mq.pop(x)) {
+        if (x < 1000 && !seen[x]) {
+            seen[x] = true;
+            ++popped;
+        }
+    }
+    std::cout << "Every element popped once: " << (popped == 1000 && mq.empty() ? "PASS" : "FAIL") << std::endl;
+
+    // usage: MultiQueue [max threads] [operations per thread]
+    size_t max_threads = argc > 1 ? std::stoull(argv[1]) : std::max<unsigned>(1, std::thread::hardware_concurrency());
+    size_t ops = argc > 2 ? std::stoull(argv[2]) : 2000000;
+    const size_t prefill = 1000000;
+
+    std::cout << "\n--- Rank error (c = 2, single thread, " << prefill << " elements) ---" << std::endl;
+    for (size_t p : {1, 4, 16, 64}) {
+        MultiQueue<uint32_t> q(p);
+        rankErrorStats stats = measureRankError(q, prefill, 1000000);
+        std::cout << "P = " << p << ": mean rank error " << stats.mean << ", max " << stats.max << std::endl;
+    }
+
+    std::cout << "\n--- Throughput (Mops/s), " << ops << " operations per thread ---" << std::endl;
+    for (size_t t = 1; t <= max_threads; t = (t * 2 > max_threads && t != max_threads) ? max_threads : t * 2) {
+        MultiQueue<uint32_t> relaxed(t);
+        LockedQueue<uint32_t> locked;
+        double relaxed_rate = throughput(relaxed, t, prefill, ops);
+        double locked_rate = throughput(locked, t, prefill, ops);
+        std::cout << t << " threads: MultiQueue " << relaxed_rate << ", mutex + single heap " << locked_rate << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,483 @@
+/*
+Persistent (versioned) AVL map with path copying.
+An update copies the O(log n) nodes on the search path and returns a new version, every other
+node is shared with the old version. Nodes are immutable once built and freed by an atomic
+reference count, so any version can be read from any thread without locks, and a snapshot is
+just one more reference to the root.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "map.hpp"
+
+template<class Key, class T, class Compare = std::less<Key>>
+class PersistentMap {
+private:
+    struct Node {
+        const Key key;
+        const T value;
+        Node *const left;
+        Node *const right;
+        const int height;
+        mutable std::atomic<size_t> refs;// versions and parents pointing to this node
+
+        Node(const Key &key_, const T &value_, Node *left_, Node *right_)
+            : key(key_), value(value_), left(left_), right(right_),
+              height(std::max(heightOf(left_), heightOf(right_)) + 1), refs(1) {
+            live_nodes.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        ~Node() {
+            live_nodes.fetch_sub(1, std::memory_order_relaxed);
+        }
+    };
+
+    // an AVL tree of height h has at least fib(h + 2) - 1 nodes, 96 levels is far more than the memory allows
+    static const int MAX_HEIGHT = 96;
+
+    static std::atomic<size_t> live_nodes;
+
+    Node *root;
+    size_t current_size;
+    Compare less;
+
+    PersistentMap(Node *root_, size_t size_) : root(root_), current_size(size_) {}
+
+    static int heightOf(const Node *t) {
+        return t == nullptr ? 0 : t->height;
+    }
+
+    static Node *retain(Node *t) {
+        if (t != nullptr) {
+            t->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        return t;
+    }
+
+    /**
+     * @brief drop one reference, freeing every node that is no longer used by any version
+     */
+    static void release(Node *t) {
+        Node *stack[2 * MAX_HEIGHT];
+        int top = 0;
+        if (t != nullptr) stack[top++] = t;
+        while (top > 0) {
+            t = stack[--top];
+            if (t->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (t->left != nullptr) stack[top++] = t->left;
+                if (t->right != nullptr) stack[top++] = t->right;
+                delete t;
+            }
+        }
+    }
+
+    // The rotations build new nodes, since the nodes they move may belong to other versions.
+    // They take over the references to left and right, and give up the one to the node they replace.
+
+    static Node *rotateRight(const Key &key, const T &value, Node *left, Node *right) {
+        Node *result = new Node(left->key, left->value, retain(left->left),
+                                new Node(key, value, retain(left->right), right));
+        release(left);
+        return result;
+    }
+
+    static Node *rotateLeft(const Key &key, const T &value, Node *left, Node *right) {
+        Node *result = new Node(right->key, right->value,
+                                new Node(key, value, left, retain(right->left)), retain(right->right));
+        release(right);
+        return result;
+    }
+
+    /**
+     * @brief a new node (key, value) over left and right, which differ in height by at most 2,
+     * rotated when they differ by 2 (LL / LR / RR / RL, the same cases as AVLTree)
+     */
+    static Node *balance(const Key &key, const T &value, Node *left, Node *right) {
+        int lh = heightOf(left), rh = heightOf(right);
+        if (lh - rh == 2) {
+            if (heightOf(left->left) < heightOf(left->right)) {
+                // LR: rotate the left child first
+                Node *new_left = rotateLeft(left->key, left->value, retain(left->left), retain(left->right));
+                release(left);
+                left = new_left;
+            }
+            return rotateRight(key, value, left, right);
+        }
+        if (rh - lh == 2) {
+            if (heightOf(right->right) < heightOf(right->left)) {
+                // RL: rotate the right child first
+                Node *new_right = rotateRight(right->key, right->value, retain(right->left), retain(right->right));
+                release(right);
+                right = new_right;
+            }
+            return rotateLeft(key, value, left, right);
+        }
+        return new Node(key, value, left, right);
+    }
+
+    /**
+     * @brief the new version of subtree t with key set to value
+     */
+    Node *insert(const Node *t, const Key &key, const T &value, bool &inserted) const {
+        if (t == nullptr) {
+            inserted = true;
+            return new Node(key, value, nullptr, nullptr);
+        }
+        if (less(key, t->key)) {
+            Node *left = insert(t->left, key, value, inserted);
+            return balance(t->key, t->value, left, retain(t->right));
+        }
+        if (less(t->key, key)) {
+            Node *right = insert(t->right, key, value, inserted);
+            return balance(t->key, t->value, retain(t->left), right);
+        }
+        inserted = false;
+        return new Node(t->key, value, retain(t->left), retain(t->right));
+    }
+
+    /**
+     * @brief the new version of subtree t without its smallest node, which is returned in min
+     */
+    Node *eraseMin(const Node *t, const Node *&min) const {
+        if (t->left == nullptr) {
+            min = t;
+            return retain(t->right);
+        }
+        Node *left = eraseMin(t->left, min);
+        return balance(t->key, t->value, left, retain(t->right));
+    }
+
+    /**
+     * @brief the new version of subtree t without key, nullptr in erased if key is not there
+     */
+    Node *erase(const Node *t, const Key &key, bool &erased) const {
+        if (t == nullptr) {
+            erased = false;
+            return nullptr;
+        }
+        if (less(key, t->key)) {
+            Node *left = erase(t->left, key, erased);
+            if (!erased) {
+                release(left);
+                return nullptr;
+            }
+            return balance(t->key, t->value, left, retain(t->right));
+        }
+        if (less(t->key, key)) {
+            Node *right = erase(t->right, key, erased);
+            if (!erased) {
+                release(right);
+                return nullptr;
+            }
+            return balance(t->key, t->value, retain(t->left), right);
+        }
+
+        erased = true;
+        if (t->left == nullptr) return retain(t->right);
+        if (t->right == nullptr) return retain(t->left);
+        // replace t with the smallest node of the right subtree
+        const Node *min;
+        Node *right = eraseMin(t->right, min);
+        return balance(min->key, min->value, retain(t->left), right);
+    }
+
+    template<class Visitor>
+    static void forEach(const Node *t, Visitor &visit) {
+        if (t == nullptr) return;
+        forEach(t->left, visit);
+        visit(t->key, t->value);
+        forEach(t->right, visit);
+    }
+
+public:
+    PersistentMap() : root(nullptr), current_size(0) {}
+
+    /**
+     * @brief A snapshot: O(1), the two versions share every node
+     */
+    PersistentMap(const PersistentMap &other) : root(retain(other.root)), current_size(other.current_size) {}
+
+    PersistentMap(PersistentMap &&other) noexcept : root(other.root), current_size(other.current_size) {
+        other.root = nullptr;
+        other.current_size = 0;
+    }
+
+    PersistentMap &operator=(const PersistentMap &other) {
+        if (this != &other) {
+            Node *old = root;
+            root = retain(other.root);
+            current_size = other.current_size;
+            release(old);
+        }
+        return *this;
+    }
+
+    PersistentMap &operator=(PersistentMap &&other) noexcept {
+        if (this != &other) {
+            release(root);
+            root = other.root;
+            current_size = other.current_size;
+            other.root = nullptr;
+            other.current_size = 0;
+        }
+        return *this;
+    }
+
+    ~PersistentMap() {
+        release(root);
+    }
+
+    size_t size() const {
+        return current_size;
+    }
+
+    bool empty() const {
+        return current_size == 0;
+    }
+
+    int height() const {
+        return heightOf(root);
+    }
+
+    /**
+     * @brief The value of key in this version, nullptr if it is not there.
+     * The pointer stays valid as long as some version holding it is alive.
+     */
+    const T *find(const Key &key) const {
+        const Node *t = root;
+        while (t != nullptr) {
+            if (less(key, t->key)) {
+                t = t->left;
+            } else if (less(t->key, key)) {
+                t = t->right;
+            } else {
+                return &t->value;
+            }
+        }
+        return nullptr;
+    }
+
+    size_t count(const Key &key) const {
+        return find(key) == nullptr ? 0 : 1;
+    }
+
+    /**
+     * @brief The version with key set to value, this version is unchanged. O(log n) new nodes
+     */
+    PersistentMap insert(const Key &key, const T &value) const {
+        bool inserted;
+        Node *new_root = insert(root, key, value, inserted);
+        return PersistentMap(new_root, current_size + (inserted ? 1 : 0));
+    }
+
+    /**
+     * @brief The version without key, this version is unchanged. O(log n) new nodes
+     */
+    PersistentMap erase(const Key &key) const {
+        bool erased;
+        Node *new_root = erase(root, key, erased);
+        if (!erased) {
+            return *this;
+        }
+        return PersistentMap(new_root, current_size - 1);
+    }
+
+    /**
+     * @brief Visit the elements in order of key, visit(const Key &, const T &)
+     */
+    template<class Visitor>
+    void forEach(Visitor visit) const {
+        forEach(root, visit);
+    }
+
+    /**
+     * @brief The number of nodes alive in all versions of this map type, to measure sharing
+     */
+    static size_t liveNodes() {
+        return live_nodes.load(std::memory_order_relaxed);
+    }
+};
+
+template<class Key, class T, class Compare>
+std::atomic<size_t> PersistentMap<Key, T, Compare>::live_nodes{0};
+
+/**
+ * @brief VmRSS of this process in KB
+ */
+long long residentKB() {
+    FILE *status = std::fopen("/proc/self/status", "r");
+    if (status == nullptr) return -1;
+    char line[256];
+    long long kb = -1;
+    while (std::fgets(line, sizeof(line), status) != nullptr) {
+        if (std::strncmp(line, "VmRSS:", 6) == 0) {
+            std::sscanf(line + 6, "%lld", &kb);
+            break;
+        }
+    }
+    std::fclose(status);
+    return kb;
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "--- Persistent Map Tests ---" << std::endl;
+    PersistentMap<int, std::string> v0;
+    PersistentMap<int, std::string> v1 = v0.insert(1, "one").insert(2, "two").insert(3, "three");
+    PersistentMap<int, std::string> v2 = v1.insert(2, "TWO").erase(1);
+    std::cout << "v0 size " << v0.size() << ", v1 size " << v1.size() << ", v2 size " << v2.size()
+              << " (Expected: 0 3 2)" << std::endl;
+    std::cout << "v1[2] = " << *v1.find(2) << ", v2[2] = " << *v2.find(2) << ", v2 has 1: " << v2.count(1)
+              << " (Expected: two TWO 0)" << std::endl;
+
+    // every version against its own std::map
+    std::mt19937 gen(2025);
+    bool pass = true;
+    {
+        std::vector<PersistentMap<int, int>> versions(1);
+        std::vector<std::map<int, int>> expected(1);
+        for (int i = 0; i < 3000; ++i) {
+            size_t from = gen() % versions.size();
+            int key = gen() % 500;
+            if (gen() % 3 == 0) {
+                versions.push_back(versions[from].erase(key));
+                expected.push_back(expected[from]);
+                expected.back().erase(key);
+            } else {
+                versions.push_back(versions[from].insert(key, i));
+                expected.push_back(expected[from]);
+                expected.back()[key] = i;
+            }
+        }
+        for (size_t i = 0; i < versions.size() && pass; ++i) {
+            std::vector<std::pair<int, int>> items;
+            versions[i].forEach([&items](int k, int v) { items.emplace_back(k, v); });
+            pass = items == std::vector<std::pair<int, int>>(expected[i].begin(), expected[i].end()) &&
+                   versions[i].size() == expected[i].size();
+        }
+    }
+    std::cout << "Random versions: " << (pass ? "PASS" : "FAIL") << ", nodes left: "
+              << PersistentMap<int, int>::liveNodes() << " (Expected: 0)" << std::endl;
+
+    // readers take snapshots while a writer moves amounts between accounts, every snapshot must add up
+    {
+        const int accounts = 1000, per_account = 100;
+        PersistentMap<int, int> bank;
+        for (int i = 0; i < accounts; ++i) {
+            bank = bank.insert(i, per_account);
+        }
+        std::mutex publish;// guards only the handoff of the latest version, reads take no lock
+        PersistentMap<int, int> latest = bank;
+        std::atomic<bool> done{false};
+        std::atomic<size_t> checked{0}, broken{0};
+
+        std::vector<std::thread> readers;
+        for (int r = 0; r < 3; ++r) {
+            readers.emplace_back([&]() {
+                while (!done.load()) {
+                    PersistentMap<int, int> snapshot;
+                    {
+                        std::lock_guard<std::mutex> guard(publish);
+                        snapshot = latest;
+                    }
+                    long long total = 0;
+                    snapshot.forEach([&total](int, int v) { total += v; });
+                    checked.fetch_add(1);
+                    if (total != (long long) accounts * per_account) broken.fetch_add(1);
+                }
+            });
+        }
+        std::mt19937 writer_gen(7);
+        for (int i = 0; i < 200000; ++i) {
+            int from = writer_gen() % accounts, to = writer_gen() % accounts;
+            if (from == to) continue;
+            bank = bank.insert(from, *bank.find(from) - 1);
+            bank = bank.insert(to, *bank.find(to) + 1);
+            if (i % 16 == 0) {
+                std::lock_guard<std::mutex> guard(publish);
+                latest = bank;
+            }
+        }
+        done = true;
+        for (auto &reader : readers) {
+            reader.join();
+        }
+        std::cout << "Concurrent snapshots: " << checked.load() << " checked, "
+                  << (broken.load() == 0 && checked.load() > 0 ? "PASS" : "FAIL") << std::endl;
+    }
+
+    // usage: PersistentMap [map size] [snapshots]
+    size_t n = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    size_t snapshots = argc > 2 ? std::stoull(argv[2]) : 20;
+    const size_t updates_per_snapshot = 100;
+    std::cout << "\n--- Benchmark: " << n << " keys, " << snapshots << " snapshots, "
+              << updates_per_snapshot << " updates between snapshots ---" << std::endl;
+    std::vector<int> keys(n);
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = int(i);
+    }
+    std::shuffle(keys.begin(), keys.end(), gen);
+
+    // persistent: snapshot = copy of the handle
+    {
+        PersistentMap<int, int> current;
+        for (int key : keys) {
+            current = current.insert(key, key);
+        }
+        long long rss_before = residentKB();
+        size_t nodes_before = PersistentMap<int, int>::liveNodes();
+        std::vector<PersistentMap<int, int>> kept;
+        double snapshot_ns = 0;
+        for (size_t s = 0; s < snapshots; ++s) {
+            for (size_t u = 0; u < updates_per_snapshot; ++u) {
+                int key = keys[gen() % n];
+                current = current.insert(key, key + 1);
+            }
+            auto start = std::chrono::high_resolution_clock::now();
+            kept.push_back(current);
+            auto end = std::chrono::high_resolution_clock::now();
+            snapshot_ns += std::chrono::duration<double, std::nano>(end - start).count();
+        }
+        std::cout << "PersistentMap: " << snapshot_ns / snapshots << " ns per snapshot, "
+                  << PersistentMap<int, int>::liveNodes() - nodes_before << " extra nodes, "
+                  << residentKB() - rss_before << " KB extra RSS" << std::endl;
+    }
+
+    // sjtu::map: snapshot = copy constructor
+    {
+        sjtu::map<int, int> current;
+        for (int key : keys) {
+            current[key] = key;
+        }
+        long long rss_before = residentKB();
+        std::vector<sjtu::map<int, int> *> kept;
+        double snapshot_ns = 0;
+        for (size_t s = 0; s < snapshots; ++s) {
+            for (size_t u = 0; u < updates_per_snapshot; ++u) {
+                int key = keys[gen() % n];
+                current[key] = key + 1;
+            }
+            auto start = std::chrono::high_resolution_clock::now();
+            kept.push_back(new sjtu::map<int, int>(current));
+            auto end = std::chrono::high_resolution_clock::now();
+            snapshot_ns += std::chrono::duration<double, std::nano>(end - start).count();
+        }
+        std::cout << "sjtu::map full copy: " << snapshot_ns / snapshots << " ns per snapshot, "
+                  << snapshots * n << " extra nodes, " << residentKB() - rss_before << " KB extra RSS" << std::endl;
+        for (auto copy : kept) {
+            delete copy;
+        }
+    }
+    return 0;
+}
@@ -8,33 +8,31 @@
  * Do you code and make progress today?
  * Copyright (c) 2025 by Xiyuan Yang, All Rights Reserved. 
  */
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 
-template<class KEY, class OTHER>
-struct set {
-    KEY key;
-    OTHER other;
-};
-
-
-// Dynamic Search Table
-template<class Key, class Other>
-class dynamicSearchTable {
-public:
-    // finding elements of x
-    virtual set<Key, Other> *find(const Key &x) const = 0;
-
-    // insert element, maintaining the order
-    virtual void insert(const set<Key, Other> &x) = 0;
+#include "dynamicSearchTable.hpp"
 
-    // remove an element, maintaining the order
-    virtual void remove(const Key &x) = 0;
+/**
+ * @brief The default augmentation of RBT: nothing is kept per subtree
+ */
+struct noAugment {
+    static const bool enabled = false;
 
-    virtual ~dynamicSearchTable() {}
+    template<class Data>
+    static void update(Data &, const Data *, const Data *) {}
 };
 
-template<class Key, class Other>
+/**
+ * @brief Red-Black tree
+ * 
+ * @tparam Augment keeps a summary of every subtree in the data of its root, e.g. the max
+ * endpoint of an interval tree. Augment::update(data, left, right) recomputes the summary
+ * from the data of the two children (nullptr for an empty child); it is called after every
+ * rotation and on the path of every insertion and deletion.
+ */
+template<class Key, class Other, class Augment = noAugment>
 class RBT {
     enum colourT { RED,
                    BLACK };
@@ -100,95 +98,88 @@ private:
     }
 
     /**
-     * @brief adjust the tree structure when deletion happens
-     * 
-     * @param parent 
-     * @param current 
-     * @param brother brother node of the current node
+     * @brief recompute the augmented summary of t from its children
      */
-    void removeAdjust(RBTNode *parent, RBTNode *current, RBTNode *brother, Key del) {
-        if (current->colour == RED) {
-            // no adjustment happens, all is well
-            return;
+    static void pull(RBTNode *t) {
+        Augment::update(t->data, t->left ? &t->left->data : nullptr, t->right ? &t->right->data : nullptr);
+    }
+
+    int height(RBTNode *t) const {
+        if (t == nullptr) {
+            return 0;
         }
+        return std::max(height(t->left), height(t->right)) + 1;
+    }
+
+    static bool isBlack(RBTNode *t) {
+        return t == nullptr || t->colour == BLACK;
+    }
 
-        if (current == root) {
-            if (current->left != nullptr && current->right != nullptr && current->right->colour == current->left->colour) {
-                current->colour = RED;
-                current->left->colour = current->right->colour = BLACK;
+    /**
+     * @brief adjust the tree structure when deletion happens.
+     * The subtree on the left_side (or right) of parent lost one black node.
+     * The rotations move the data instead of the nodes, so the nodes in path never change.
+     * 
+     * @param path the ancestors of parent, path[top - 1] is the parent of parent
+     * @param top 
+     * @param parent 
+     * @param left_side 
+     */
+    void removeAdjust(RBTNode **path, int top, RBTNode *parent, bool left_side) {
+        while (parent != nullptr) {
+            RBTNode *current = left_side ? parent->left : parent->right;
+            if (!isBlack(current)) {
+                // a red node can take the lost black
+                current->colour = BLACK;
                 return;
             }
-        }
 
-        if ((current->left != nullptr && current->left->colour == BLACK || current->left == nullptr) &&
-            (current->right != nullptr && current->right->colour == BLACK || current->right == nullptr)) {
-            // has both black child or nullptr
-            if ((brother->left != nullptr && brother->left->colour == BLACK || brother->left == nullptr) &&
-                (brother->right != nullptr && brother->right->colour == BLACK || brother->right == nullptr)) {
-                parent->colour = BLACK;
-                brother->colour = current->colour = RED;
-            } else {
-                if (parent->left == brother) {
-                    if (brother->left != nullptr && brother->left->colour == RED) {
-                        brother->left->colour = BLACK;
-                        LL(parent);
-                        parent = brother;
-                    } else {
-                        LR(parent);
-                        parent = parent->right;
-                        parent->colour = BLACK;
-                    }
-                } else if (brother->right && brother->right->colour == RED) {
-                    brother->right->colour = BLACK;
+            RBTNode *brother = left_side ? parent->right : parent->left;
+            if (brother->colour == RED) {
+                // make the brother black: rotate it to the top, the old parent becomes red
+                if (left_side) {
                     RR(parent);
-                    parent = brother;
                 } else {
-                    RL(parent);
-                    parent = parent->left;
-                    parent->colour = BLACK;
+                    LL(parent);
                 }
-                current->colour = RED;
+                path[top++] = parent;
+                parent = left_side ? parent->left : parent->right;
+                brother = left_side ? parent->right : parent->left;
             }
-        } else {
-            // has at least one red child
-            if (current->data.key == del) {
-                // current node is the node tobe deleted
-                if (current->left != nullptr && current->right != nullptr) {
-                    if (current->right->colour == BLACK) {
-                        LL(current);
-                        current = current->right;
-                    }
+
+            RBTNode *near = left_side ? brother->left : brother->right;
+            RBTNode *far = left_side ? brother->right : brother->left;
+            if (isBlack(near) && isBlack(far)) {
+                // both the children of the brother are black, move the problem upwards
+                brother->colour = RED;
+                if (parent->colour == RED) {
+                    parent->colour = BLACK;
                     return;
                 }
+                current = parent;
+                parent = (top > 0) ? path[--top] : nullptr;
+                left_side = parent != nullptr && parent->left == current;
+                continue;
+            }
 
-                if (current->left != nullptr) {
-                    LL(current);
-                    parent = current;
-                    current = current->right;
+            if (isBlack(far)) {
+                // make the far child red
+                if (left_side) {
+                    LL(brother);
                 } else {
-                    RR(current);
-                    parent = current;
-                    current = current->right;
+                    RR(brother);
                 }
-            } else {
-                // the node is not the node to be deleted
-                // update the node
-                parent = current;
-                current = (del < parent->data.key) ? parent->left : parent->right;
-                brother = (current == parent->left) ? parent->right : parent->left;
-
-                if (current->colour == BLACK) {
-                    if (brother == parent->right) {
-                        RR(parent);
-                    } else {
-                        LL(parent);
-                    }
+                far = left_side ? brother->right : brother->left;
+            }
 
-                    parent = brother;
-                    brother = (current == parent->left) ? parent->right : parent->left;
-                    removeAdjust(parent, current, brother, del);
-                }
+            // the brother takes the place of parent
+            if (left_side) {
+                RR(parent);
+            } else {
+                LL(parent);
             }
+            far->colour = BLACK;
+            return;
         }
     }
 
@@ -205,6 +196,11 @@ private:
         p->data = tmp.data;
         p->left = p->right;
         p->right = tmp.right;
+
+        if (Augment::enabled) {
+            pull(p);
+            pull(grandparent);
+        }
     }
 
     void LR(RBTNode *grandparent) {
@@ -220,6 +216,12 @@ private:
         t->data = tmp.data;
         t->left = t->right;
         t->right = tmp.right;
+
+        if (Augment::enabled) {
+            pull(p);
+            pull(t);
+            pull(grandparent);
+        }
     }
 
     void RR(RBTNode *grandparent) {
@@ -235,6 +237,11 @@ private:
         p->data = tmp.data;
         p->right = p->left;
         p->left = tmp.left;
+
+        if (Augment::enabled) {
+            pull(p);
+            pull(grandparent);
+        }
     }
 
     void RL(RBTNode *grandparent) {
@@ -250,6 +257,12 @@ private:
         t->data = tmp.data;
         t->right = t->left;
         t->left = tmp.left;
+
+        if (Augment::enabled) {
+            pull(p);
+            pull(t);
+            pull(grandparent);
+        }
     }
 
 public:
@@ -285,7 +298,44 @@ public:
             // find nothing
             return nullptr;
         } else {
-            return (set<Key, Other> *) t;
+            return &t->data;
+        }
+    }
+
+    /**
+     * @brief return the height of the tree
+     * 
+     * @return int 
+     */
+    int height() const {
+        return height(root);
+    }
+
+    /**
+     * @brief In-order traversal which skips every subtree whose root data satisfies prune,
+     * it is how queries use the augmented summaries.
+     * 
+     * @param prune bool(const set &subtree_root), true to skip the whole subtree
+     * @param visit bool(const set &), false to stop the traversal
+     */
+    template<class Prune, class Visit>
+    void walk(Prune prune, Visit visit) const {
+        RBTNode *stack[128];
+        int top = 0;
+        RBTNode *t = root;
+        while (true) {
+            while (t != nullptr && !prune(t->data)) {
+                stack[top++] = t;
+                t = t->left;
+            }
+            if (top == 0) {
+                return;
+            }
+            t = stack[--top];
+            if (!visit(t->data)) {
+                return;
+            }
+            t = t->right;
         }
     }
 
@@ -295,7 +345,7 @@ public:
      * @param x 
      */
     void insert(const set<Key, Other> &x) {
-        RBTNode *grandparent, *parent, *t;
+        RBTNode *greatgrandparent, *grandparent, *parent, *t;
 
         if (root == nullptr) {
             // insert in the empty tree
@@ -303,19 +353,38 @@ public:
             return;
         }
 
-        grandparent = parent = t = root;
+        greatgrandparent = grandparent = parent = t = root;
         // from the top to the bottom, adjust the structure
         while (true) {
             if (t != nullptr) {
+                if (t->data.key == x.key) {
+                    // Repetetion makes no operations
+                    return;
+                }
                 // the two child are red while t is black
                 if (t->left && t->left->colour == RED && t->right && t->right->colour == RED) {
                     // swap the colour and then adjust the tree
                     t->left->colour = t->right->colour = BLACK;
                     t->colour = RED;
-                    insertAdjust(grandparent, parent, t);
+                    if (parent->colour == RED && parent != root) {
+                        Key current = t->data.key;
+                        insertAdjust(grandparent, parent, t);
+                        // the rotations move the data instead of the nodes:
+                        // grandparent now holds the data of parent (LL, RR) or of t (LR, RL)
+                        if (grandparent->data.key == current) {
+                            t = grandparent;
+                            parent = greatgrandparent;
+                        } else {
+                            parent = grandparent;
+                        }
+                        grandparent = greatgrandparent;
+                    } else {
+                        insertAdjust(grandparent, parent, t);
+                    }
                 }
                 // for other cases, we don't do anything
-                // update the three nodes
+                // update the four nodes
+                greatgrandparent = grandparent;
                 grandparent = parent;
                 parent = t;
                 t = (t->data.key > x.key) ? t->left : t->right;
@@ -330,6 +399,19 @@ public:
                     parent->right = t;
                 }
 
+                if (Augment::enabled) {
+                    // the tree above was exact without x, fix the ancestors of x bottom-up
+                    pull(t);
+                    RBTNode *path[128];
+                    int top = 0;
+                    for (RBTNode *p = root; p != t; p = (x.key < p->data.key) ? p->left : p->right) {
+                        path[top++] = p;
+                    }
+                    while (top > 0) {
+                        pull(path[--top]);
+                    }
+                }
+
                 insertAdjust(grandparent, parent, t);
 
                 // make sure after the adjustment, the root node remain black
@@ -340,59 +422,64 @@ public:
     }
 
     void remove(const Key &x) {
-        Key del = x;
-        RBTNode *current, *parent, *brother;
+        // the ancestors of t, a red-black tree with n nodes is at most 2 log(n + 1) high
+        RBTNode *path[128];
+        int top = 0;
 
-        if (root == nullptr) {
-            return;
+        RBTNode *t = root;
+        while (t != nullptr && t->data.key != x) {
+            path[top++] = t;
+            t = (x < t->data.key) ? t->left : t->right;
         }
-
-        // the tree has only one element
-        if (root->data.key == x && root->left == nullptr && root->right == nullptr) {
-            delete root;
-            root = nullptr;
+        if (t == nullptr) {
+            // find nothing
             return;
         }
 
-        parent = current = brother = root;
-        while (true) {
-            removeAdjust(parent, current, brother, del);
-            if (current->data.key == del && current->left != nullptr && current->right != nullptr) {
-                // has two child and is just the node to be deleted
-                RBTNode *tmp = current->right;
-                while (tmp->left != nullptr) {
-                    tmp = tmp->left;
-                }
-                // find the first element in the right-subtree
-                current->data = tmp->data;
-                del = tmp->data.key;
-                parent = current;
-                current = current->right;
-                brother = parent->left;
+        if (t->left != nullptr && t->right != nullptr) {
+            // has two child: replace it with the first element in the right-subtree
+            path[top++] = t;
+            RBTNode *tmp = t->right;
+            while (tmp->left != nullptr) {
+                path[top++] = tmp;
+                tmp = tmp->left;
             }
+            t->data = tmp->data;
+            t = tmp;
+        }
 
-            if (current->data.key == del) {
-                // has at least most child
-                // delete the current node
-                delete current;
-                if (parent->left == current) {
-                    parent->left = nullptr;
-                } else {
-                    parent->right = nullptr;
-                }
+        // now t has at most one child
+        RBTNode *child = (t->left != nullptr) ? t->left : t->right;
+        RBTNode *parent = (top > 0) ? path[--top] : nullptr;
+        bool left_side = parent != nullptr && parent->left == t;
+        if (parent == nullptr) {
+            root = child;
+        } else if (left_side) {
+            parent->left = child;
+        } else {
+            parent->right = child;
+        }
 
-                // upwards the node of current
-                current = (del < parent->data.key) ? parent->left : parent->right;
+        colourT colour = t->colour;
+        delete t;
+        if (Augment::enabled && parent != nullptr) {
+            // the rotations in removeAdjust keep the summaries of untouched subtrees
+            pull(parent);
+            for (int i = top - 1; i >= 0; --i) {
+                pull(path[i]);
             }
-
-            // update the nodes
-            parent = current;
-            current = (del < parent->data.key) ? parent->left : parent->right;
+        }
+        if (colour == BLACK) {
+            removeAdjust(path, top, parent, left_side);
+        }
+        if (root != nullptr) {
+            root->colour = BLACK;
         }
     }
 };
 
 
+#ifndef BENCHMARK_NO_MAIN
 int main() {
     // Create an RBT instance
     RBT<int, std::string> rbt;
@@ -447,4 +534,5 @@ int main() {
     std::cout << "\nRBT test completed." << std::endl;
 
     return 0;
-}
\ No newline at end of file
+}
+#endif
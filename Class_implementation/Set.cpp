@@ -12,7 +12,19 @@
 implementation for data structure: Set
 */
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "algorithm.hpp"
+
 template<class KEY, class OTHER>
 struct set {
     KEY key;
@@ -92,6 +104,493 @@ int binarySearch(set<KEY, OTHER> *data, int size, const KEY &x) {
 }
 
 
-/*
-TODO chunking search and interpolation search
-*/
\ No newline at end of file
+/**
+ * @brief A static search index over a sorted 1-based set, with the keys relaid out in Eytzinger
+ * (BFS) order: node k has its children at 2k and 2k + 1. The top levels share a few cache lines,
+ * the descent has no unpredictable branch (k = 2k + (key[k] < x)), and the descendants some
+ * levels down are prefetched, so the memory latency of a probe overlaps the next probes.
+ * The results are 1-based indices into the original array, like binarySearch.
+ *
+ * @tparam KEY 
+ * @tparam OTHER 
+ */
+template<class KEY, class OTHER>
+class EytzingerSet {
+private:
+    static const size_t CACHE_LINE = 64;
+    //the descendants this many levels down fit in one cache line, at least the grandchildren
+    static const int PREFETCH_LEVELS = sizeof(KEY) <= 4 ? 4 : sizeof(KEY) <= 8 ? 3 : 2;
+    static const int BATCH = 16;
+
+    KEY *keys;//keys[1..size] in BFS order, aligned to a cache line
+    int *rank;//rank[k]: the index of keys[k] in the sorted array, rank[0] = size + 1
+    int size;
+    int depth;//the number of levels every search goes through, the last level may be partial
+
+    //fill the BFS positions under k with data[next..] in order
+    void build(const set<KEY, OTHER> *data, int k, int &next) {
+        if (k > size) return;
+        build(data, 2 * k, next);
+        new (keys + k) KEY(data[next].key);
+        rank[k] = next++;
+        build(data, 2 * k + 1, next);
+    }
+
+    /**
+     * @brief The k at the end of a descent went right at every level where key < x, so the
+     * lower bound is where it last went left: drop the trailing 1 bits and one more bit
+     */
+    static size_t resolve(size_t k) {
+        return (k >> (__builtin_ctzll(~k) + 1));
+    }
+
+    /**
+     * @brief The BFS position of the first key >= x, 0 if there is none
+     */
+    size_t descend(const KEY &x) const {
+        size_t k = 1;
+        while (k <= size_t(size)) {
+            __builtin_prefetch(keys + (k << PREFETCH_LEVELS));
+            k = 2 * k + (keys[k] < x);
+        }
+        return resolve(k);
+    }
+
+public:
+    /**
+     * @brief Build the index from a sorted 1-based array data[1..size], O(size)
+     */
+    EytzingerSet(const set<KEY, OTHER> *data, int size_) : size(size_), depth(0) {
+        keys = static_cast<KEY *>(::operator new[]((size + 1) * sizeof(KEY), std::align_val_t(CACHE_LINE)));
+        rank = new int[size + 1];
+        rank[0] = size + 1;
+        int next = 1;
+        build(data, 1, next);
+        while ((1ll << depth) <= size) ++depth;
+    }
+
+    EytzingerSet(const EytzingerSet &) = delete;
+    EytzingerSet &operator=(const EytzingerSet &) = delete;
+
+    ~EytzingerSet() {
+        for (int k = 1; k <= size; ++k) keys[k].~KEY();
+        ::operator delete[](keys, std::align_val_t(CACHE_LINE));
+        delete[] rank;
+    }
+
+    /**
+     * @brief The index of the first element with key >= x, size + 1 if there is none
+     */
+    int lower_bound(const KEY &x) const {
+        return rank[descend(x)];
+    }
+
+    /**
+     * @brief The index of the element with key x, 0 for finding nothing
+     */
+    int find(const KEY &x) const {
+        size_t k = descend(x);
+        return (k != 0 && !(x < keys[k])) ? rank[k] : 0;
+    }
+
+    bool contains(const KEY &x) const {
+        size_t k = descend(x);
+        return k != 0 && !(x < keys[k]);
+    }
+
+    /**
+     * @brief lower_bound of xs[0..count) into result, BATCH searches go down level by level
+     * together so that their cache misses overlap
+     */
+    void lower_bound(const KEY *xs, int count, int *result) const {
+        size_t k[BATCH];
+        for (int begin = 0; begin < count; begin += BATCH) {
+            int batch = count - begin < BATCH ? count - begin : BATCH;
+            for (int j = 0; j < batch; ++j) k[j] = 1;
+            //every path has depth - 1 full levels, only the last one can run past size
+            for (int level = 1; level < depth; ++level) {
+                for (int j = 0; j < batch; ++j) {
+                    __builtin_prefetch(keys + (k[j] << PREFETCH_LEVELS));
+                    k[j] = 2 * k[j] + (keys[k[j]] < xs[begin + j]);
+                }
+            }
+            for (int j = 0; j < batch; ++j) {
+                if (k[j] <= size_t(size)) k[j] = 2 * k[j] + (keys[k[j]] < xs[begin + j]);
+                result[begin + j] = rank[resolve(k[j])];
+            }
+        }
+    }
+};
+
+/**
+ * @brief Interpolation search for ordered set with arithmetic keys: the probe is placed where x
+ * would be if the keys between low and high were evenly spread, O(log log n) probes on uniform keys.
+ * Guard: after ceil(log2 log2 n) + 1 interpolation probes the rest is binary search, so skewed keys
+ * cost O(log n) probes instead of O(n).
+ *
+ * @tparam KEY 
+ * @tparam OTHER 
+ * @param data 
+ * @param size 
+ * @param x 
+ * @param probes if not nullptr, the number of probes is stored here
+ * @return int the index of the found element (1-based), 0 for finding nothing
+ */
+template<class KEY, class OTHER>
+int interpolationSearch(set<KEY, OTHER> *data, int size, const KEY &x, int *probes = nullptr) {
+    static_assert(std::is_arithmetic<KEY>::value, "interpolation needs arithmetic keys");
+    int low = 1, high = size, count = 0;
+    int budget = 1;//the interpolation probes before falling back to binary search
+    for (int levels = 1; (1ll << levels) < size; levels *= 2) ++budget;
+    int result = 0;
+    while (low <= high && !(x < data[low].key) && !(data[high].key < x)) {
+        int mid;
+        if (count < budget && data[low].key < data[high].key) {
+            double ratio = (double(x) - double(data[low].key)) / (double(data[high].key) - double(data[low].key));
+            mid = low + int(ratio * (high - low));
+            mid = mid < low ? low : (mid > high ? high : mid);
+        } else {
+            mid = low + (high - low) / 2;
+        }
+        ++count;
+        if (x == data[mid].key) {
+            result = mid;
+            break;
+        }
+        if (x < data[mid].key) {
+            high = mid - 1;
+        } else {
+            low = mid + 1;
+        }
+    }
+    if (probes != nullptr) *probes = count;
+    return result;
+}
+
+/**
+ * @brief Chunked search: a top level holds the first key of every block of the ordered set, so a
+ * search is a binary search of the dense top level and then of one block. The block size is a
+ * trade-off: small blocks make the top level larger but the last search short, l1BlockSize keeps the
+ * top level in L1.
+ *
+ * @tparam KEY 
+ * @tparam OTHER 
+ */
+template<class KEY, class OTHER>
+class BlockIndex {
+private:
+    set<KEY, OTHER> *data;
+    int size;
+    int block_size;
+    int blocks;
+    KEY *firsts;//firsts[b] = data[1 + b * block_size].key
+
+public:
+    //the default block spans 4 cache lines, its binary search touches few lines
+    static int defaultBlockSize() {
+        int block_size = int(256 / sizeof(set<KEY, OTHER>));
+        return block_size > 1 ? block_size : 1;
+    }
+
+    //the block size that keeps the top level in 32 KB (L1), at the cost of larger blocks
+    static int l1BlockSize(int size) {
+        int top = int(32768 / sizeof(KEY));
+        int block_size = 16;
+        while (size / block_size > top) block_size *= 2;
+        return block_size;
+    }
+
+    /**
+     * @brief Build the top level of the ordered set data[1..size], block_size 0 for the default
+     */
+    BlockIndex(set<KEY, OTHER> *data_, int size_, int block_size_ = 0)
+        : data(data_), size(size_), block_size(block_size_ > 0 ? block_size_ : defaultBlockSize()) {
+        blocks = (size + block_size - 1) / block_size;
+        firsts = new KEY[blocks > 0 ? blocks : 1];
+        for (int b = 0; b < blocks; ++b) firsts[b] = data[1 + b * block_size].key;
+    }
+
+    BlockIndex(const BlockIndex &) = delete;
+    BlockIndex &operator=(const BlockIndex &) = delete;
+
+    ~BlockIndex() {
+        delete[] firsts;
+    }
+
+    int blockSize() const {
+        return block_size;
+    }
+
+    /**
+     * @brief The index of the first element with key >= x, size + 1 if there is none
+     */
+    int lower_bound(const KEY &x) const {
+        //the last block starting at a key <= x, the answer is in it or at the start of the next one
+        int b = int(std::upper_bound(firsts, firsts + blocks, x) - firsts) - 1;
+        if (b < 0) return 1;
+        set<KEY, OTHER> *begin = data + 1 + b * block_size;
+        set<KEY, OTHER> *end = data + 1 + std::min(size, (b + 1) * block_size);
+        return int(std::lower_bound(begin, end, x, [](const set<KEY, OTHER> &a, const KEY &key) { return a.key < key; }) - data);
+    }
+
+    /**
+     * @brief The index of the element with key x, 0 for finding nothing
+     */
+    int find(const KEY &x) const {
+        int index = lower_bound(x);
+        return (index <= size && data[index].key == x) ? index : 0;
+    }
+};
+
+/**
+ * @brief Pick the search of an ordered set from its keys: interpolation search is tried on sampled
+ * keys (present and absent), and is chosen if it needs far fewer probes than binary search, since
+ * its probes hardly ever hit the cache; otherwise a BlockIndex for sets larger than the cache,
+ * and binarySearch for small ones.
+ *
+ * @tparam KEY 
+ * @tparam OTHER 
+ */
+template<class KEY, class OTHER>
+class AdaptiveSearch {
+public:
+    enum method { BINARY, INTERPOLATION, BLOCK };
+
+private:
+    set<KEY, OTHER> *data;
+    int size;
+    method chosen;
+    BlockIndex<KEY, OTHER> *blocks;
+    double mean_probes;//of interpolation search on the samples
+
+public:
+    AdaptiveSearch(set<KEY, OTHER> *data_, int size_, int samples = 256)
+        : data(data_), size(size_), chosen(BINARY), blocks(nullptr), mean_probes(0) {
+        if (size < 2) return;
+        long long total = 0;
+        int tries = 0;
+        for (int i = 0; i < samples; ++i) {
+            int index = 1 + int((long long) (size - 1) * i / (samples > 1 ? samples - 1 : 1));
+            int probes;
+            interpolationSearch(data, size, data[index].key, &probes);
+            total += probes;
+            //a key between two neighbours, absent unless the keys are consecutive integers
+            if (index < size) {
+                KEY between = data[index].key + (data[index + 1].key - data[index].key) / 2;
+                interpolationSearch(data, size, between, &probes);
+                total += probes;
+                ++tries;
+            }
+            ++tries;
+        }
+        mean_probes = double(total) / tries;
+        double binary_probes = std::log2(double(size));
+        if (mean_probes * 3 <= binary_probes) {
+            chosen = INTERPOLATION;
+        } else if (size * sizeof(set<KEY, OTHER>) > (1u << 20)) {
+            chosen = BLOCK;
+            blocks = new BlockIndex<KEY, OTHER>(data, size);
+        }
+    }
+
+    AdaptiveSearch(const AdaptiveSearch &) = delete;
+    AdaptiveSearch &operator=(const AdaptiveSearch &) = delete;
+
+    ~AdaptiveSearch() {
+        delete blocks;
+    }
+
+    method choice() const {
+        return chosen;
+    }
+
+    const char *name() const {
+        return chosen == INTERPOLATION ? "interpolation" : (chosen == BLOCK ? "block" : "binary");
+    }
+
+    double sampledProbes() const {
+        return mean_probes;
+    }
+
+    /**
+     * @brief The index of the element with key x, 0 for finding nothing
+     */
+    int find(const KEY &x) const {
+        switch (chosen) {
+            case INTERPOLATION:
+                return interpolationSearch(data, size, x);
+            case BLOCK:
+                return blocks->find(x);
+            default:
+                return binarySearch(data, size, x);
+        }
+    }
+};
+
+#ifndef BENCHMARK_NO_MAIN
+int main(int argc, char *argv[]) {
+    std::cout << "--- Eytzinger Search Tests ---" << std::endl;
+    set<int, std::string> words[] = {{0, ""}, {2, "two"}, {3, "three"}, {5, "five"}, {7, "seven"}, {11, "eleven"}};
+    EytzingerSet<int, std::string> index(words, 5);
+    std::cout << "find(7): " << words[index.find(7)].other << ", find(4): " << index.find(4)
+              << ", lower_bound(4): " << index.lower_bound(4) << ", lower_bound(12): " << index.lower_bound(12)
+              << " (Expected: seven, 0, 3, 6)" << std::endl;
+
+    //every size up to 300 against binarySearch and std::lower_bound
+    bool pass = true;
+    for (int n = 0; n <= 300 && pass; ++n) {
+        std::vector<set<int, int>> data(n + 1);
+        for (int i = 1; i <= n; ++i) data[i] = set<int, int>{3 * i, i};
+        EytzingerSet<int, int> checked(data.data(), n);
+        std::vector<int> xs, batch(3 * n + 5);
+        for (int x = -1; x <= 3 * n + 3; ++x) xs.push_back(x);
+        checked.lower_bound(xs.data(), int(xs.size()), batch.data());
+        for (size_t i = 0; i < xs.size() && pass; ++i) {
+            int x = xs[i];
+            int expected = int(std::lower_bound(data.begin() + 1, data.end(), x,
+                                                [](const set<int, int> &a, int b) { return a.key < b; }) -
+                               data.begin());
+            pass = checked.lower_bound(x) == expected && batch[i] == expected &&
+                   checked.find(x) == binarySearch(data.data(), n, x) && checked.contains(x) == (binarySearch(data.data(), n, x) != 0);
+        }
+    }
+    std::cout << "All sizes: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+    std::cout << "\n--- Interpolation and Block Search Tests ---" << std::endl;
+    std::cout << "interpolationSearch(7): " << words[interpolationSearch(words, 5, 7)].other
+              << ", BlockIndex(block 2).find(11): " << words[BlockIndex<int, std::string>(words, 5, 2).find(11)].other
+              << " (Expected: seven, eleven)" << std::endl;
+    //uniform, skewed and duplicate-free clustered keys against binarySearch
+    std::mt19937 gen_test(2025);
+    pass = true;
+    for (int round = 0; round < 300 && pass; ++round) {
+        int n = 1 + int(gen_test() % 2000);
+        std::vector<set<long long, int>> data(n + 1);
+        long long key = 0;
+        for (int i = 1; i <= n; ++i) {
+            long long gap = round % 3 == 0 ? 1 + gen_test() % 100 : (round % 3 == 1 ? 1 + (1ll << (gen_test() % 40)) : (gen_test() % 50 ? 1 : 1ll << 30));
+            data[i] = set<long long, int>{key += gap, i};
+        }
+        BlockIndex<long long, int> block(data.data(), n, 1 + int(gen_test() % 64));
+        AdaptiveSearch<long long, int> adaptive(data.data(), n);
+        for (int q = 0; q < 200 && pass; ++q) {
+            long long x = q % 2 ? data[1 + gen_test() % n].key : (long long) (gen_test() % (unsigned long long) (key + 2)) - 1;
+            int expected = binarySearch(data.data(), n, x);
+            int lower = int(std::lower_bound(data.begin() + 1, data.end(), x, [](const set<long long, int> &a, long long b) { return a.key < b; }) - data.begin());
+            pass = interpolationSearch(data.data(), n, x) == expected && block.find(x) == expected &&
+                   block.lower_bound(x) == lower && adaptive.find(x) == expected;
+        }
+    }
+    std::cout << "Random keys: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+    // usage: Set [keys] [queries] [keys for the distributions]
+    int n = argc > 1 ? std::stoi(argv[1]) : 100000000;
+    int queries = argc > 2 ? std::stoi(argv[2]) : 10000000;
+    std::cout << "\n--- Benchmark: " << n << " keys, " << queries << " lookups, one core ---" << std::endl;
+    std::vector<set<int, int>> data(n + 1);
+    std::vector<int> plain(n);
+    for (int i = 1; i <= n; ++i) {
+        data[i] = set<int, int>{2 * i - 1, i};
+        plain[i - 1] = 2 * i - 1;
+    }
+    std::mt19937 gen(2025);
+    std::vector<int> xs(queries), result(queries);
+    for (int &x : xs) x = int(gen() % (2u * unsigned(n) + 1));//half of them are hits
+
+    typedef std::chrono::high_resolution_clock clock;
+    auto rate = [queries](clock::time_point begin) {
+        return queries / std::chrono::duration<double>(clock::now() - begin).count() / 1e6;
+    };
+    long long binary_hits = 0, std_sum = 0, sjtu_sum = 0, eytzinger_sum = 0, batch_sum = 0;
+
+    auto start = clock::now();
+    for (int x : xs) binary_hits += binarySearch(data.data(), n, x) != 0;
+    double binary_rate = rate(start);
+    start = clock::now();
+    for (int x : xs) {
+        std_sum += std::lower_bound(data.begin() + 1, data.end(), x, [](const set<int, int> &a, int b) { return a.key < b; }) - data.begin();
+    }
+    double std_rate = rate(start);
+    start = clock::now();
+    for (int x : xs) sjtu_sum += sjtu::lower_bound(plain.data(), plain.data() + n, x) - plain.data() + 1;
+    double sjtu_rate = rate(start);
+
+    start = clock::now();
+    EytzingerSet<int, int> eytzinger(data.data(), n);
+    double build_time = std::chrono::duration<double>(clock::now() - start).count();
+    start = clock::now();
+    for (int x : xs) eytzinger_sum += eytzinger.lower_bound(x);
+    double eytzinger_rate = rate(start);
+    start = clock::now();
+    eytzinger.lower_bound(xs.data(), queries, result.data());
+    double batch_rate = rate(start);
+    for (int r : result) batch_sum += r;
+    long long eytzinger_hits = 0;
+    for (int x : xs) eytzinger_hits += eytzinger.contains(x);
+
+    std::cout << "binarySearch: " << binary_rate << " M lookups/s" << std::endl;
+    std::cout << "std::lower_bound: " << std_rate << " M lookups/s" << std::endl;
+    std::cout << "sjtu::lower_bound: " << sjtu_rate << " M lookups/s" << std::endl;
+    std::cout << "EytzingerSet: " << eytzinger_rate << " M lookups/s (build " << build_time << " s)" << std::endl;
+    std::cout << "EytzingerSet batched: " << batch_rate << " M lookups/s" << std::endl;
+    std::cout << "Same results: "
+              << (std_sum == sjtu_sum && std_sum == eytzinger_sum && std_sum == batch_sum && binary_hits == eytzinger_hits ? "PASS" : "FAIL")
+              << std::endl;
+    data = std::vector<set<int, int>>();
+    plain = std::vector<int>();
+
+    int m = argc > 3 ? std::stoi(argv[3]) : 10000000;
+    std::cout << "\n--- Benchmark: " << m << " 64-bit keys per distribution, " << queries << " lookups ---" << std::endl;
+    const char *distributions[] = {"uniform", "lognormal", "clustered"};
+    for (int d = 0; d < 3; ++d) {
+        std::mt19937_64 gen64(2025);
+        std::vector<long long> raw(m);
+        std::lognormal_distribution<double> lognormal(0, 2);
+        std::vector<long long> centers(100);
+        for (auto &c : centers) c = (long long) (gen64() % (1ull << 40));
+        for (auto &k : raw) {
+            if (d == 0) k = (long long) (gen64() % (1ull << 40));
+            else if (d == 1) k = (long long) (lognormal(gen64) * 1e9);
+            else k = centers[gen64() % centers.size()] + (long long) (gen64() % (1ull << 24));
+        }
+        std::sort(raw.begin(), raw.end());
+        raw.erase(std::unique(raw.begin(), raw.end()), raw.end());
+        int size = int(raw.size());
+        std::vector<set<long long, int>> keys(size + 1);
+        for (int i = 1; i <= size; ++i) keys[i] = set<long long, int>{raw[i - 1], i};
+        std::vector<long long> probes(queries);
+        for (int i = 0; i < queries; ++i) {
+            probes[i] = i % 2 ? raw[gen64() % size] : raw[0] + (long long) (gen64() % (unsigned long long) (raw[size - 1] - raw[0]));
+        }
+        raw = std::vector<long long>();
+
+        BlockIndex<long long, int> block(keys.data(), size);
+        BlockIndex<long long, int> l1_block(keys.data(), size, BlockIndex<long long, int>::l1BlockSize(size));
+        auto adapt_start = clock::now();
+        AdaptiveSearch<long long, int> adaptive(keys.data(), size);
+        double select_time = std::chrono::duration<double, std::micro>(clock::now() - adapt_start).count();
+        long long sums[5] = {0, 0, 0, 0, 0};
+        double rates[5];
+        for (int method = 0; method < 5; ++method) {
+            start = clock::now();
+            long long sum = 0;
+            for (long long x : probes) {
+                if (method == 0) sum += binarySearch(keys.data(), size, x);
+                else if (method == 1) sum += interpolationSearch(keys.data(), size, x);
+                else if (method == 2) sum += block.find(x);
+                else if (method == 3) sum += l1_block.find(x);
+                else sum += adaptive.find(x);
+            }
+            rates[method] = rate(start);
+            sums[method] = sum;
+        }
+        std::cout << distributions[d] << " (" << size << " keys): binarySearch " << rates[0] << ", interpolation "
+                  << rates[1] << ", block(" << block.blockSize() << ") " << rates[2] << ", block(" << l1_block.blockSize()
+                  << ", L1 top level) " << rates[3] << ", adaptive " << rates[4]
+                  << " M lookups/s; adaptive chose " << adaptive.name() << " from " << adaptive.sampledProbes()
+                  << " sampled probes in " << select_time << " us; same results: "
+                  << (sums[0] == sums[1] && sums[0] == sums[2] && sums[0] == sums[3] && sums[0] == sums[4] ? "PASS" : "FAIL") << std::endl;
+    }
+    return 0;
+}
+#endif
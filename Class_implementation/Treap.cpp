@@ -0,0 +1,357 @@
+/*
+The implementation of Treap: a binary search tree on the keys and a max-heap on random priorities,
+so that it is balanced in expectation. Besides the dynamicSearchTable operations it splits and
+merges by key in O(log n) expected time, and builds from sorted input in O(n).
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dynamicSearchTable.hpp"
+
+template<class KEY, class OTHER>
+class Treap : public dynamicSearchTable<KEY, OTHER> {
+    struct TreapNode {
+        set<KEY, OTHER> data;
+        uint64_t priority;// a parent has a higher priority than its children
+        TreapNode *left;
+        TreapNode *right;
+
+        TreapNode(const set<KEY, OTHER> &element, uint64_t priority_)
+            : data(element), priority(priority_), left(nullptr), right(nullptr) {}
+    };
+
+private:
+    TreapNode *root;
+    uint64_t seed;// the state of the priority generator
+
+    /**
+     * @brief splitmix64, a good hash of a counter, so every position of a bulk build
+     * can get its priority independently
+     */
+    static uint64_t mix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    uint64_t nextPriority() {
+        return mix(seed++);
+    }
+
+    void makeEmpty(TreapNode *t) {
+        if (t == nullptr) {
+            return;
+        }
+        makeEmpty(t->left);
+        makeEmpty(t->right);
+        delete t;
+    }
+
+    /**
+     * @brief Split t into the keys < key (left) and the keys >= key (right)
+     */
+    static void split(TreapNode *t, const KEY &key, TreapNode *&left, TreapNode *&right) {
+        if (t == nullptr) {
+            left = right = nullptr;
+        } else if (t->data.key < key) {
+            split(t->right, key, t->right, right);
+            left = t;
+        } else {
+            split(t->left, key, left, t->left);
+            right = t;
+        }
+    }
+
+    /**
+     * @brief Merge two treaps where all keys of left < all keys of right
+     */
+    static TreapNode *merge(TreapNode *left, TreapNode *right) {
+        if (left == nullptr) return right;
+        if (right == nullptr) return left;
+        if (left->priority > right->priority) {
+            left->right = merge(left->right, right);
+            return left;
+        }
+        right->left = merge(left, right->left);
+        return right;
+    }
+
+    /**
+     * @brief The Cartesian tree of the sorted data[0, n) in O(n): the new node pops the nodes of
+     * lower priority from the right spine and takes them as its left child
+     */
+    static TreapNode *buildRange(const set<KEY, OTHER> *data, size_t n, uint64_t seed_) {
+        std::vector<TreapNode *> spine;
+        for (size_t i = 0; i < n; ++i) {
+            TreapNode *t = new TreapNode(data[i], mix(seed_ + i));
+            TreapNode *last = nullptr;
+            while (!spine.empty() && spine.back()->priority < t->priority) {
+                last = spine.back();
+                spine.pop_back();
+            }
+            t->left = last;
+            if (!spine.empty()) {
+                spine.back()->right = t;
+            }
+            spine.push_back(t);
+        }
+        return spine.empty() ? nullptr : spine.front();
+    }
+
+    int height(TreapNode *t) const {
+        if (t == nullptr) {
+            return 0;
+        }
+        return std::max(height(t->left), height(t->right)) + 1;
+    }
+
+public:
+    /**
+     * @brief Construct a new Treap object
+     *
+     * @param seed_ the seed of the priorities
+     */
+    explicit Treap(uint64_t seed_ = 2025) : root(nullptr), seed(seed_) {}
+
+    ~Treap() {
+        makeEmpty(root);
+    }
+
+    Treap(const Treap &) = delete;
+    Treap &operator=(const Treap &) = delete;
+
+    set<KEY, OTHER> *find(const KEY &x) const {
+        TreapNode *t = root;
+        while (t != nullptr && t->data.key != x) {
+            if (x < t->data.key) {
+                t = t->left;
+            } else {
+                t = t->right;
+            }
+        }
+        return t == nullptr ? nullptr : &t->data;
+    }
+
+    /**
+     * @brief Insert x, repetition makes no operations.
+     * Go down until the new node has a higher priority, then split the rest under it.
+     */
+    void insert(const set<KEY, OTHER> &x) {
+        if (find(x.key) != nullptr) {
+            return;
+        }
+        TreapNode *node = new TreapNode(x, nextPriority());
+        TreapNode **t = &root;
+        while (*t != nullptr && (*t)->priority > node->priority) {
+            t = (x.key < (*t)->data.key) ? &(*t)->left : &(*t)->right;
+        }
+        split(*t, x.key, node->left, node->right);
+        *t = node;
+    }
+
+    /**
+     * @brief Remove the element with key x, its two subtrees are merged in its place
+     */
+    void remove(const KEY &x) {
+        TreapNode **t = &root;
+        while (*t != nullptr && (*t)->data.key != x) {
+            t = (x < (*t)->data.key) ? &(*t)->left : &(*t)->right;
+        }
+        if (*t == nullptr) {
+            return;
+        }
+        TreapNode *old = *t;
+        *t = merge(old->left, old->right);
+        delete old;
+    }
+
+    /**
+     * @brief Move the elements with keys < key to left and the others to right,
+     * this treap becomes empty. O(log n) expected
+     */
+    void split(const KEY &key, Treap &left, Treap &right) {
+        TreapNode *t = root;
+        root = nullptr;
+        left.makeEmpty(left.root);
+        right.makeEmpty(right.root);
+        split(t, key, left.root, right.root);
+    }
+
+    /**
+     * @brief This treap becomes left followed by right, which requires all keys in left < all keys
+     * in right. left and right become empty. O(log n) expected
+     */
+    void merge(Treap &left, Treap &right) {
+        TreapNode *l = left.root, *r = right.root;
+        left.root = right.root = nullptr;
+        makeEmpty(root);
+        root = merge(l, r);
+    }
+
+    /**
+     * @brief Replace the content with the sorted data[0, n) (strictly increasing keys) in O(n).
+     * With thread_num > 1 every thread builds the Cartesian tree of one slice, and the slices
+     * are merged at the end, O(n / thread_num + thread_num log n).
+     */
+    void buildSorted(const set<KEY, OTHER> *data, size_t n, size_t thread_num = 1) {
+        makeEmpty(root);
+        root = nullptr;
+        uint64_t base = seed;
+        seed += n;
+        if (thread_num <= 1 || n < 100000) {
+            root = buildRange(data, n, base);
+            return;
+        }
+
+        std::vector<TreapNode *> parts(thread_num, nullptr);
+        std::vector<std::thread> pool;
+        for (size_t t = 0; t < thread_num; ++t) {
+            size_t begin = n * t / thread_num, end = n * (t + 1) / thread_num;
+            pool.emplace_back([&parts, data, begin, end, base, t]() {
+                parts[t] = buildRange(data + begin, end - begin, base + begin);
+            });
+        }
+        for (auto &thread : pool) {
+            thread.join();
+        }
+        for (TreapNode *part : parts) {
+            root = merge(root, part);
+        }
+    }
+
+    /**
+     * @brief Visit the elements with keys in [low, high) in order, visit(const set<KEY, OTHER> &)
+     */
+    template<class Visitor>
+    void range(const KEY &low, const KEY &high, Visitor visit) const {
+        std::vector<TreapNode *> stack;
+        TreapNode *t = root;
+        while (t != nullptr || !stack.empty()) {
+            // go left only while the keys can still be >= low
+            while (t != nullptr) {
+                if (t->data.key < low) {
+                    t = t->right;
+                } else {
+                    stack.push_back(t);
+                    t = t->left;
+                }
+            }
+            if (stack.empty()) {
+                return;
+            }
+            t = stack.back();
+            stack.pop_back();
+            if (!(t->data.key < high)) {
+                return;
+            }
+            visit(t->data);
+            t = t->right;
+        }
+    }
+
+    /**
+     * @brief Return the height of the treap
+     *
+     * @return int
+     */
+    int height() const {
+        return height(root);
+    }
+};
+
+#ifndef BENCHMARK_NO_MAIN
+int main(int argc, char *argv[]) {
+    std::cout << "--- Treap Tests ---" << std::endl;
+    Treap<int, std::string> treap;
+    treap.insert({10, "Ten"});
+    treap.insert({20, "Twenty"});
+    treap.insert({5, "Five"});
+    treap.insert({15, "Fifteen"});
+    treap.remove(20);
+    auto result = treap.find(15);
+    std::cout << "find(15): " << (result ? result->other : "not found") << ", find(20): "
+              << (treap.find(20) ? "found" : "not found") << " (Expected: Fifteen, not found)" << std::endl;
+
+    Treap<int, std::string> low, high;
+    treap.split(10, low, high);
+    std::cout << "split(10): low has 5: " << (low.find(5) != nullptr) << ", high has 10: "
+              << (high.find(10) != nullptr) << " (Expected: 1 1)" << std::endl;
+    treap.merge(low, high);
+    std::cout << "merge back:";
+    treap.range(0, 100, [](const set<int, std::string> &x) { std::cout << " " << x.key; });
+    std::cout << " (Expected: 5 10 15)" << std::endl;
+
+    // random operations, splits and merges against std::map
+    std::mt19937 gen(2025);
+    Treap<int, int> checked;
+    std::map<int, int> expected;
+    bool pass = true;
+    for (int i = 0; i < 200000 && pass; ++i) {
+        int key = gen() % 5000, op = gen() % 100;
+        if (op < 45) {
+            checked.insert({key, i});
+            expected.emplace(key, i);
+        } else if (op < 90) {
+            checked.remove(key);
+            expected.erase(key);
+        } else if (op < 99) {
+            auto it = expected.find(key);
+            set<int, int> *x = checked.find(key);
+            pass = (it == expected.end()) ? x == nullptr : (x != nullptr && x->other == it->second);
+        } else {
+            Treap<int, int> l, r;
+            checked.split(key, l, r);
+            checked.merge(l, r);
+            std::vector<int> keys;
+            checked.range(key - 300, key + 300, [&keys](const set<int, int> &x) { keys.push_back(x.key); });
+            std::vector<int> expected_keys;
+            for (auto it = expected.lower_bound(key - 300); it != expected.end() && it->first < key + 300; ++it) {
+                expected_keys.push_back(it->first);
+            }
+            pass = keys == expected_keys;
+        }
+    }
+    std::cout << "Random operations: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+    // usage: Treap [elements] [threads]
+    size_t n = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    size_t thread_num = argc > 2 ? std::stoull(argv[2]) : std::max<unsigned>(1, std::thread::hardware_concurrency());
+    std::cout << "\n--- Benchmark: building from " << n << " sorted elements ---" << std::endl;
+    std::vector<set<int, int>> sorted(n);
+    for (size_t i = 0; i < n; ++i) {
+        sorted[i] = set<int, int>{int(2 * i), int(i)};
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Treap<int, int> inserted;
+    for (auto &x : sorted) {
+        inserted.insert(x);
+    }
+    auto middle = std::chrono::high_resolution_clock::now();
+    Treap<int, int> built;
+    built.buildSorted(sorted.data(), n);
+    auto end = std::chrono::high_resolution_clock::now();
+    Treap<int, int> parallel;
+    parallel.buildSorted(sorted.data(), n, thread_num);
+    auto parallel_end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::milli> insert_time = middle - start, build_time = end - middle,
+                                              parallel_time = parallel_end - end;
+    std::cout << "Insert one by one: " << insert_time.count() << " ms, height " << inserted.height() << std::endl;
+    std::cout << "Cartesian build: " << build_time.count() << " ms, height " << built.height() << std::endl;
+    std::cout << "Parallel build (" << thread_num << " threads): " << parallel_time.count() << " ms, height "
+              << parallel.height() << std::endl;
+    std::cout << "Same tree: " << (built.height() == parallel.height() && parallel.find(2 * int(n / 3)) != nullptr ? "PASS" : "FAIL")
+              << std::endl;
+    return 0;
+}
+#endif
@@ -11,9 +11,13 @@
 /*
 The implementation of Tree and Binary Tree
 */
+#include <chrono>
+#include <cstddef>
 #include <iostream>
 #include <queue>
 #include <stack>
+#include <string>
+#include <vector>
 //Abstract class
 template<class T>
 class Tree {
@@ -32,11 +36,11 @@ template<class T>
 class bTree {
 public:
     virtual void clear() = 0;
-    virtual bool isEmpty() = 0;
-    virtual T Root(T flag) = 0;
+    virtual bool isEmpty() const = 0;
+    virtual T Root(T flag) const = 0;
     virtual T parent(T x, T flag) const = 0;
-    virtual T lchild(T x, T flag) const = 0;
-    virtual T rchild(T x, T flag) const = 0;
+    virtual T l_child(T x, T flag) const = 0;
+    virtual T r_child(T x, T flag) const = 0;
     virtual void delLeft(T x) = 0;
     virtual void delRight(T x) = 0;
     virtual void preOrder() const = 0;
@@ -58,15 +62,117 @@ private:
         T data;
 
         Node() : left(nullptr), right(nullptr) {}
-        Node(T item, Node *L = nullptr, Node *R = nullptr) : data(item), left(L), right(R) {}
+        Node(T item, Node *L = nullptr, Node *R = nullptr) : left(L), right(R), data(item) {}
         ~Node() {}
     };
 
     Node *root;//二叉树的根节点
+
+    //层次序遍历复用的环形队列，容量为2的幂
+    mutable Node **ring = nullptr;
+    mutable size_t ring_capacity = 0;
+
 public:
+    /**
+     * @brief Morris (threaded) traversal as an iterator, in-order or pre-order, with O(1) extra memory.
+     * The walk borrows the empty right pointers of the tree as threads back to the ancestors,
+     * so only one traversal may run on a tree at a time, and the tree must not change meanwhile.
+     * Destroying the iterator before the end removes the threads left, in O(height) steps
+     * plus the right spines of the left subtrees on the path.
+     */
+    template<bool PRE_ORDER>
+    class morrisIterator {
+        friend class binaryTree;
+
+    private:
+        Node *root;   //where the threads are removed from
+        Node *current;//the node visited, nullptr at the end
+        Node *walk;   //where the walk goes on
+
+        explicit morrisIterator(Node *root_) : root(root_), current(nullptr), walk(root_) { advance(); }
+
+        //go on with the Morris walk until the next visit
+        void advance() {
+            while (walk != nullptr) {
+                if (walk->left == nullptr) {
+                    current = walk;
+                    walk = walk->right;
+                    return;
+                }
+                Node *pred = walk->left;
+                while (pred->right != nullptr && pred->right != walk) pred = pred->right;
+                if (pred->right == nullptr) {
+                    //first arrival: thread the predecessor back to walk, then go left
+                    pred->right = walk;
+                    if (PRE_ORDER) {
+                        current = walk;
+                        walk = walk->left;
+                        return;
+                    }
+                    walk = walk->left;
+                } else {
+                    //second arrival through the thread: the left subtree is done
+                    pred->right = nullptr;
+                    if (!PRE_ORDER) {
+                        current = walk;
+                        walk = walk->right;
+                        return;
+                    }
+                    walk = walk->right;
+                }
+            }
+            current = nullptr;
+        }
+
+        //remove the threads of the ancestors whose left subtree holds current, going down from the root
+        void restore() {
+            Node *t = root;
+            while (t != nullptr) {
+                Node *next = t->right;
+                if (t->left != nullptr) {
+                    Node *pred = t->left;
+                    while (pred->right != nullptr && pred->right != t) pred = pred->right;
+                    if (pred->right == t) {
+                        pred->right = nullptr;
+                        next = t->left;
+                    }
+                }
+                if (t == current) break;
+                t = next;
+            }
+            current = walk = nullptr;
+        }
+
+    public:
+        morrisIterator() : root(nullptr), current(nullptr), walk(nullptr) {}
+        morrisIterator(const morrisIterator &) = delete;
+        morrisIterator &operator=(const morrisIterator &) = delete;
+        morrisIterator(morrisIterator &&other) : root(other.root), current(other.current), walk(other.walk) {
+            other.current = other.walk = nullptr;
+        }
+        ~morrisIterator() {
+            if (current != nullptr) restore();
+        }
+
+        const T &operator*() const { return current->data; }
+        const T *operator->() const { return &current->data; }
+        morrisIterator &operator++() {
+            advance();
+            return *this;
+        }
+        bool operator==(const morrisIterator &other) const { return current == other.current; }
+        bool operator!=(const morrisIterator &other) const { return current != other.current; }
+    };
+
+    typedef morrisIterator<false> midOrderIterator;
+    typedef morrisIterator<true> preOrderIterator;
+
     binaryTree() : root(nullptr) {}
     binaryTree(T x) { root = new Node(x); }
-    ~binaryTree() { clear(root); }
+    ~binaryTree() {
+        clear(root);
+        delete[] ring;
+    }
     void clear() { clear(root); }
     bool isEmpty() const { return root == nullptr; }
     T Root(T flag) const {
@@ -74,7 +180,7 @@ public:
         else
             return root->data;
     }
-    T parent(T x, T flag) const { return flag; }
+    T parent(T, T flag) const { return flag; }
     T l_child(T x, T flag) const;
     T r_child(T x, T flag) const;
     void delRight(T x);
@@ -84,9 +190,24 @@ public:
     void postOrder() const;
     void levelOrder() const;
     void creatTree(T flag);
+    void creatTree(const T *data, size_t n, T flag);
     int size() const { return size(root); }
     int height() const { return height(root); }
 
+    //Morris遍历的迭代器，end()为默认构造的迭代器
+    midOrderIterator midOrderBegin() const { return midOrderIterator(root); }
+    midOrderIterator midOrderEnd() const { return midOrderIterator(); }
+    preOrderIterator preOrderBegin() const { return preOrderIterator(root); }
+    preOrderIterator preOrderEnd() const { return preOrderIterator(); }
+
+    //访问者遍历：visit(const T &)返回false时提前结束，整棵树遍历完返回true
+    template<class Visitor>
+    bool preOrder(Visitor visit) const;
+    template<class Visitor>
+    bool midOrder(Visitor visit) const;
+    template<class Visitor>
+    bool levelOrder(Visitor visit) const;
+
 private:
     Node *find(T x, Node *t) const;
     void clear(Node *&t);
@@ -234,6 +355,57 @@ void binaryTree<T>::postOrder() const {
     std::cout << std::endl;
 }
 
+//访问者遍历
+//Morris前序，O(1)额外空间
+template<class T>
+template<class Visitor>
+bool binaryTree<T>::preOrder(Visitor visit) const {
+    for (preOrderIterator it = preOrderBegin(); it != preOrderEnd(); ++it) {
+        if (!visit(*it)) return false;//it析构时拆除剩下的线索
+    }
+    return true;
+}
+
+//Morris中序，O(1)额外空间
+template<class T>
+template<class Visitor>
+bool binaryTree<T>::midOrder(Visitor visit) const {
+    for (midOrderIterator it = midOrderBegin(); it != midOrderEnd(); ++it) {
+        if (!visit(*it)) return false;
+    }
+    return true;
+}
+
+//层次序，队列是复用的环形缓冲区，只在树变宽时扩容
+template<class T>
+template<class Visitor>
+bool binaryTree<T>::levelOrder(Visitor visit) const {
+    if (root == nullptr) return true;
+    size_t head = 0, tail = 0;//下标对容量取模，tail - head为队列长度
+    auto push = [this, &head, &tail](Node *t) {
+        if (tail - head == ring_capacity) {
+            size_t capacity = ring_capacity == 0 ? 64 : ring_capacity * 2;
+            Node **grown = new Node *[capacity];
+            for (size_t i = head; i != tail; ++i) grown[i - head] = ring[i & (ring_capacity - 1)];
+            delete[] ring;
+            ring = grown;
+            ring_capacity = capacity;
+            tail -= head;
+            head = 0;
+        }
+        ring[tail++ & (ring_capacity - 1)] = t;
+    };
+
+    push(root);
+    while (head != tail) {
+        Node *current = ring[head++ & (ring_capacity - 1)];
+        if (!visit(current->data)) return false;
+        if (current->left) push(current->left);
+        if (current->right) push(current->right);
+    }
+    return true;
+}
+
 //私有，以某节点为根的树的大小
 template<class T>
 int binaryTree<T>::size(binaryTree<T>::Node *t) const {
@@ -253,7 +425,7 @@ int binaryTree<T>::height(binaryTree<T>::Node *t) const {
 
 //私有，查找以t为根的树中值为x的结点，并返回指针
 template<class T>
-binaryTree<T>::Node *binaryTree<T>::find(T x, binaryTree<T>::Node *t) const {
+typename binaryTree<T>::Node *binaryTree<T>::find(T x, binaryTree<T>::Node *t) const {
     Node *tmp;
     if (t == nullptr) {
         return nullptr;
@@ -263,7 +435,7 @@ binaryTree<T>::Node *binaryTree<T>::find(T x, binaryTree<T>::Node *t) const {
         return t;
     }
 
-    if (tmp = find(x, t->left)) {
+    if ((tmp = find(x, t->left)) != nullptr) {
         return tmp;
     } else {
         return find(x, t->right);
@@ -314,7 +486,7 @@ void binaryTree<T>::creatTree(T flag) {
     root = new Node(x);
     que.push(root);
     while (!que.empty()) {
-        tmp = que.top();
+        tmp = que.front();
         que.pop();
         std::cout << "Enter" << tmp->data << "two sons (" << flag << ") represents the null node";
         std::cin >> l_data >> r_data;
@@ -327,6 +499,27 @@ void binaryTree<T>::creatTree(T flag) {
     }
 }
 
+//由层次序数组创建树，flag表示空结点，与上面的输入格式相同
+template<class T>
+void binaryTree<T>::creatTree(const T *data, size_t n, T flag) {
+    clear(root);
+    if (n == 0 || data[0] == flag) return;
+    std::queue<Node *> que;
+    size_t i = 0;
+    root = new Node(data[i++]);
+    que.push(root);
+    while (!que.empty() && i < n) {
+        Node *tmp = que.front();
+        que.pop();
+        if (i < n && data[i++] != flag) {
+            que.push(tmp->left = new Node(data[i - 1]));
+        }
+        if (i < n && data[i++] != flag) {
+            que.push(tmp->right = new Node(data[i - 1]));
+        }
+    }
+}
+
 //输出树
 template<class T>
 void printTree(const binaryTree<T> &t, T flag) {
@@ -343,3 +536,123 @@ void printTree(const binaryTree<T> &t, T flag) {
         if (r != flag) q.enQueue(r);
     }
 }
+
+int main(int argc, char *argv[]) {
+    std::cout << "--- Binary Tree Traversal Tests ---" << std::endl;
+    //      A
+    //    B   C
+    //   D   E F
+    const char data[] = {'A', 'B', 'C', 'D', '#', 'E', 'F'};
+    binaryTree<char> tree;
+    tree.creatTree(data, sizeof(data), '#');
+    auto print = [](const char &x) {
+        std::cout << x << ' ';
+        return true;
+    };
+    std::cout << "Morris pre-order: ";
+    tree.preOrder(print);
+    std::cout << "(Expected: A B D C E F)" << std::endl;
+    std::cout << "Morris in-order: ";
+    tree.midOrder(print);
+    std::cout << "(Expected: D B A E C F)" << std::endl;
+    std::cout << "Level order: ";
+    tree.levelOrder(print);
+    std::cout << "(Expected: A B C D E F)" << std::endl;
+    std::cout << "Iterator, stop at E: ";
+    for (auto it = tree.midOrderBegin(); it != tree.midOrderEnd() && *it != 'E'; ++it) std::cout << *it << ' ';
+    std::cout << "then in-order again: ";
+    tree.midOrder(print);
+    std::cout << "(Expected: D B A then D B A E C F)" << std::endl;
+
+    //random shapes against a recursive traversal on child indices, with early stops in between
+    unsigned seed = 2025;
+    auto next = [&seed]() { return seed = seed * 1103515245u + 12345u, (seed >> 8) & 0xffff; };
+    bool pass = true;
+    for (int round = 0; round < 300 && pass; ++round) {
+        size_t n = 1 + next() % 200;
+        std::vector<int> levels(n);
+        for (size_t i = 0; i < n; ++i) levels[i] = (i > 0 && next() % 3 == 0) ? -1 : int(i);
+        binaryTree<int> checked;
+        checked.creatTree(levels.data(), n, -1);
+
+        //the same tree on indices, built the way creatTree consumes the array
+        std::vector<int> left(n, -1), right(n, -1), que(1, 0);
+        for (size_t head = 0, i = 1; head < que.size() && i < n; ++head) {
+            if (i < n && levels[i++] != -1) que.push_back(left[que[head]] = int(i - 1));
+            if (i < n && levels[i++] != -1) que.push_back(right[que[head]] = int(i - 1));
+        }
+        std::vector<int> pre, mid;
+        struct reference {
+            static void walk(const std::vector<int> &l, const std::vector<int> &r, int t, std::vector<int> &pre, std::vector<int> &mid) {
+                if (t == -1) return;
+                pre.push_back(t);
+                walk(l, r, l[t], pre, mid);
+                mid.push_back(t);
+                walk(l, r, r[t], pre, mid);
+            }
+        };
+        reference::walk(left, right, 0, pre, mid);
+
+        size_t stop = next() % n;
+        size_t count = 0;
+        checked.preOrder([&count, stop](const int &) { return count++ != stop; });
+        count = 0;
+        checked.midOrder([&count, stop](const int &) { return count++ != stop; });
+
+        std::vector<int> morris_pre, morris_mid, level;
+        checked.preOrder([&morris_pre](const int &x) { morris_pre.push_back(x); return true; });
+        checked.midOrder([&morris_mid](const int &x) { morris_mid.push_back(x); return true; });
+        checked.levelOrder([&level](const int &x) { level.push_back(x); return true; });
+        pass = morris_pre == pre && morris_mid == mid && level == que && checked.size() == int(que.size());
+    }
+    std::cout << "Random shapes: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+    // usage: Tree [nodes]
+    size_t n = argc > 1 ? std::stoull(argv[1]) : 100000000;
+    std::cout << "\n--- Benchmark: complete tree of " << n << " nodes ---" << std::endl;
+    binaryTree<unsigned> big;
+    {
+        std::vector<unsigned> values(n);
+        for (size_t i = 0; i < n; ++i) values[i] = unsigned(i);
+        big.creatTree(values.data(), n, unsigned(-1));
+    }
+    typedef std::chrono::high_resolution_clock clock;
+    auto millis = [](clock::time_point begin) { return std::chrono::duration<double, std::milli>(clock::now() - begin).count(); };
+
+    auto start = clock::now();
+    int counted = big.size();
+    double recursive_time = millis(start);
+    unsigned long long mid_sum = 0, pre_sum = 0, level_sum = 0;
+    start = clock::now();
+    big.midOrder([&mid_sum](const unsigned &x) { mid_sum += x; return true; });
+    double mid_time = millis(start);
+    start = clock::now();
+    big.preOrder([&pre_sum](const unsigned &x) { pre_sum += x; return true; });
+    double pre_time = millis(start);
+    start = clock::now();
+    big.levelOrder([&level_sum](const unsigned &x) { level_sum += x; return true; });
+    double level_time = millis(start);
+
+    //the deepest node on the leftmost path of the right subtree, the pre-order search stops partway
+    size_t target = 2;
+    while (target * 2 + 1 < n) target = target * 2 + 1;
+    size_t visited = 0;
+    start = clock::now();
+    bool missed = big.preOrder([&visited, target](const unsigned &x) { return ++visited, x != target; });
+    double search_time = millis(start);
+    start = clock::now();
+    big.levelOrder([target](const unsigned &x) { return x != target; });
+    double level_search_time = millis(start);
+
+    std::cout << "Recursive size(): " << recursive_time << " ms" << std::endl;
+    std::cout << "Morris in-order: " << mid_time << " ms" << std::endl;
+    std::cout << "Morris pre-order: " << pre_time << " ms" << std::endl;
+    std::cout << "Level order (ring buffer): " << level_time << " ms" << std::endl;
+    std::cout << "Pre-order search stopped after " << visited << " nodes: " << search_time
+              << " ms, level order search: " << level_search_time << " ms" << std::endl;
+    unsigned long long expected_sum = (unsigned long long) n * (n - 1) / 2;
+    std::cout << "Same results: "
+              << (size_t(counted) == n && mid_sum == expected_sum && pre_sum == expected_sum && level_sum == expected_sum && !missed ? "PASS" : "FAIL")
+              << std::endl;
+    return 0;
+}
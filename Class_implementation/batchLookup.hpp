@@ -0,0 +1,17 @@
+#ifndef BATCH_LOOKUP_HPP
+#define BATCH_LOOKUP_HPP
+
+#include <cstddef>
+
+/*
+The batched lookups (find_batch) of the hash tables and sjtu::map: in a table much larger than the
+cache, a lookup mostly waits for cache misses, which one find after another pays in turn. find_batch
+takes FIND_BATCH keys through every step of the lookup together and prefetches what the next step
+of each key reads before any of them reads it, so the misses of the group overlap (group prefetching,
+Chen, Ailamaki, Gibbons and Mowry, "Improving Hash Join Performance through Prefetching", 2004).
+*/
+
+// the lookups in flight at once, enough to cover a memory access without the prefetches evicting each other
+const size_t FIND_BATCH = 16;
+
+#endif//BATCH_LOOKUP_HPP
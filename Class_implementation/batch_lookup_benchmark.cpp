@@ -0,0 +1,132 @@
+/*
+Benchmark of the batched lookups: find_batch against one find per key on close_Hash_Table,
+open_Hash_Table, sjtu::linked_hashmap and sjtu::map, with tables much larger than the cache.
+Half of the queries hit and half miss, the batches are answered BATCH_SIZE keys at a time,
+and every batch result is checked against find.
+
+usage: batch_lookup_benchmark [elements] [queries]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#define BENCHMARK_NO_MAIN
+#include "close_Hash_Table.cpp"
+#include "linked_hashmap.hpp"
+#include "map.hpp"
+#include "open_Hash_Table.cpp"
+#undef BENCHMARK_NO_MAIN
+
+// the queries come in batches of this many keys
+const size_t BATCH_SIZE = 4096;
+
+double seconds(std::chrono::high_resolution_clock::time_point start) {
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count();
+}
+
+/**
+ * @brief Time one find per query, then find_batch over the same queries, and print both throughputs.
+ * single(key) and batch(keys, n, first) return the found flags, which must agree.
+ */
+template<class Single, class Batch>
+void compare(const std::string &name, const std::vector<int> &queries, Single single, Batch batch) {
+    size_t n = queries.size();
+    std::vector<char> expected(n), found(n);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < n; ++i) {
+        expected[i] = single(queries[i]);
+    }
+    double single_time = seconds(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t begin = 0; begin < n; begin += BATCH_SIZE) {
+        batch(queries.data() + begin, std::min(BATCH_SIZE, n - begin), found.data() + begin);
+    }
+    double batch_time = seconds(start);
+
+    size_t hits = std::count(expected.begin(), expected.end(), 1);
+    std::cout << name << ": find " << n / single_time / 1e6 << " M/s, find_batch " << n / batch_time / 1e6
+              << " M/s, speedup " << single_time / batch_time << "x, hits " << hits << ", "
+              << (expected == found ? "PASS" : "FAIL") << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    size_t query_num = argc > 2 ? std::stoull(argv[2]) : 10000000;
+
+    std::mt19937 gen(2025);
+    std::uniform_int_distribution<int> dis(0, INT32_MAX);
+    std::vector<int> keys(n);
+    for (auto &key : keys) {
+        key = dis(gen);
+    }
+    // half of the queries are inserted keys, the other half are (almost surely) missing
+    std::vector<int> queries(query_num);
+    for (size_t i = 0; i < query_num; ++i) {
+        queries[i] = (i % 2 == 0) ? keys[gen() % n] : dis(gen);
+    }
+    std::shuffle(queries.begin(), queries.end(), gen);
+    std::cout << "--- " << n << " elements, " << query_num << " lookups in batches of " << BATCH_SIZE
+              << " ---" << std::endl;
+
+    {
+        close_Hash_Table<int, int> table(int(2 * n));
+        for (int key : keys) {
+            table.insert({key, key});
+        }
+        std::vector<set<int, int> *> results(BATCH_SIZE);
+        compare(
+                "close_Hash_Table", queries, [&](int key) { return table.find(key) != nullptr; },
+                [&](const int *batch, size_t count, char *found) {
+                    table.find_batch(batch, count, results.data());
+                    for (size_t i = 0; i < count; ++i) found[i] = results[i] != nullptr;
+                });
+    }
+    {
+        open_Hash_Table<int, int> table(n);
+        for (int key : keys) {
+            table.insert({key, key});
+        }
+        std::vector<set<int, int> *> results(BATCH_SIZE);
+        compare(
+                "open_Hash_Table", queries, [&](int key) { return table.find(key) != nullptr; },
+                [&](const int *batch, size_t count, char *found) {
+                    table.find_batch(batch, count, results.data());
+                    for (size_t i = 0; i < count; ++i) found[i] = results[i] != nullptr;
+                });
+    }
+    {
+        sjtu::linked_hashmap<int, int> table;
+        for (int key : keys) {
+            table.insert(sjtu::pair<const int, int>(key, key));
+        }
+        std::vector<sjtu::linked_hashmap<int, int>::iterator> results(BATCH_SIZE);
+        compare(
+                "sjtu::linked_hashmap", queries, [&](int key) { return table.find(key) != table.end(); },
+                [&](const int *batch, size_t count, char *found) {
+                    table.find_batch(batch, count, results.data());
+                    for (size_t i = 0; i < count; ++i) found[i] = results[i] != table.end();
+                });
+    }
+    {
+        sjtu::map<int, int> tree;
+        for (int key : keys) {
+            tree.insert(sjtu::pair<const int, int>(key, key));
+        }
+        std::vector<sjtu::map<int, int>::iterator> results(BATCH_SIZE);
+        compare(
+                "sjtu::map", queries, [&](int key) { return tree.find(key) != tree.end(); },
+                [&](const int *batch, size_t count, char *found) {
+                    tree.find_batch(batch, count, results.data());
+                    for (size_t i = 0; i < count; ++i) found[i] = results[i] != tree.end();
+                });
+    }
+    return 0;
+}
@@ -9,36 +9,293 @@
  * Copyright (c) 2025 by Xiyuan Yang, All Rights Reserved. 
  */
 
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <queue>
 #include <random>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
-template<class KEY, class OTHER>
-struct set {
-    KEY key;
-    OTHER other;
-};
+#include "batchLookup.hpp"
+#include "dynamicSearchTable.hpp"
 
-// Dynamic Search Table
+/*
+Robin Hood hashing: linear probing where an element being inserted takes the slot of any element
+that is closer to its home slot, so the probe distances stay short and even. A lookup stops as soon
+as it meets an element closer to home than itself, and a removal shifts the following elements one
+slot back instead of leaving a tombstone. The table doubles when the load factor would exceed max_load.
+*/
 template<class Key, class Other>
-class dynamicSearchTable {
+class close_Hash_Table : public dynamicSearchTable<Key, Other> {
+private:
+    // the probe distance of every slot, kept apart from the elements so that probing scans bytes:
+    // 0 for empty, d + 1 for an element d slots after its home slot
+    unsigned char *distance;
+    set<Key, Other> *array;
+    size_t slot_count;// a power of two
+    size_t mask;
+    int shift;// home slot = the top bits of the multiplicative hash
+    size_t element_count;
+    double max_load;
+
+    // the stored distance can not reach this, the table grows instead
+    static const unsigned char MAX_DISTANCE = 255;
+    // the doublings one insert may make to fit an element, before it gives up
+    static const int MAX_GROWTH = 3;
+
+    // function pointer (hash function)
+    int (*key)(const Key &x);
+
+    // if the key value is int iteself, we no need for another function
+    static int defaultKey(const int &x) {
+        return x;
+    }
+
+
+    /**
+     * @brief Fibonacci hashing of key(x), so that keys with equal low bits still spread over the table
+     */
+    size_t home(const Key &x) const {
+        return (uint64_t(uint32_t(key(x))) * 0x9E3779B97F4A7C15ull) >> shift;
+    }
+
+    void allocate(size_t count) {
+        slot_count = count;
+        mask = count - 1;
+        shift = 64;
+        while (count > 1) {
+            count >>= 1;
+            --shift;
+        }
+        distance = new unsigned char[slot_count]();
+        array = new set<Key, Other>[slot_count];
+    }
+
+    /**
+     * @brief Linear probing for x from its home slot pos, until an element closer to its own home
+     */
+    set<Key, Other> *probe(const Key &x, size_t pos) const {
+        for (unsigned char d = 1; distance[pos] >= d; ++d) {
+            if (distance[pos] == d && array[pos].key == x) {
+                return array + pos;
+            }
+            pos = (pos + 1) & mask;
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Whether x can be placed without a probe distance reaching MAX_DISTANCE: the element in hand
+     * is never farther from its home than the first empty slot is from the home of x.
+     * same counts the elements on the way with the same key(x) value, which no growth can separate.
+     */
+    bool fits(const Key &x, size_t &same) const {
+        size_t pos = home(x);
+        same = 0;
+        for (unsigned char d = 1; d < MAX_DISTANCE; ++d) {
+            if (distance[pos] == 0) {
+                return true;
+            }
+            same += key(array[pos].key) == key(x);
+            pos = (pos + 1) & mask;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Put x, which is not in the table and fits, by Robin Hood displacement: x swaps with the
+     * first element closer to its home, and that element goes on looking for a slot
+     */
+    void place(set<Key, Other> x) {
+        size_t pos = home(x.key);
+        unsigned char d = 1;
+        while (distance[pos] != 0) {
+            if (distance[pos] < d) {
+                std::swap(array[pos], x);
+                std::swap(distance[pos], d);
+            }
+            pos = (pos + 1) & mask;
+            ++d;
+        }
+        array[pos] = std::move(x);
+        distance[pos] = d;
+    }
+
+    /**
+     * @brief Move the elements to count >= slot_count slots. Every element fits: the home slots only
+     * get finer, so no probe distance grows.
+     */
+    void rehash(size_t count) {
+        unsigned char *old_distance = distance;
+        set<Key, Other> *old_array = array;
+        size_t old_count = slot_count;
+        allocate(count);
+        for (size_t i = 0; i < old_count; ++i) {
+            if (old_distance[i] != 0) {
+                place(std::move(old_array[i]));
+            }
+        }
+        delete[] old_distance;
+        delete[] old_array;
+    }
+
 public:
-    // finding elements of x
-    virtual set<Key, Other> *find(const Key &x) const = 0;
+    /**
+     * @brief Construct a new close_Hash_Table object
+     *
+     * @param length the initial number of slots, rounded up to a power of two
+     * @param f the hash function
+     * @param max_load_ the table doubles when the load factor would exceed it, in (0, 1)
+     */
+    close_Hash_Table(int length = 101, int (*f)(const Key &x) = defaultKey, double max_load_ = 0.875) {
+        if (!(max_load_ > 0 && max_load_ < 1)) {
+            throw std::invalid_argument("The max load factor should be in (0, 1)!");
+        }
+        size_t count = 8;
+        while (count < size_t(std::max(length, 1))) {
+            count *= 2;
+        }
+        allocate(count);
+        element_count = 0;
+        max_load = max_load_;
+        key = f;
+    }
+    ~close_Hash_Table() {
+        delete[] distance;
+        delete[] array;
+    }
 
-    // insert element, maintaining the order
-    virtual void insert(const set<Key, Other> &x) = 0;
+    close_Hash_Table(const close_Hash_Table &) = delete;
+    close_Hash_Table &operator=(const close_Hash_Table &) = delete;
 
-    // remove an element, maintaining the order
-    virtual void remove(const Key &x) = 0;
+    set<Key, Other> *find(const Key &x) const {
+        return probe(x, home(x));
+    }
 
-    virtual ~dynamicSearchTable() {}
+    /**
+     * @brief results[i] = find(keys[i]) for i in [0, n).
+     * The keys are hashed FIND_BATCH at a time, and the distance byte and the element of every home slot
+     * are prefetched before any of them is probed.
+     */
+    void find_batch(const Key *keys, size_t n, set<Key, Other> **results) const {
+        size_t pos[FIND_BATCH];
+        for (size_t begin = 0; begin < n; begin += FIND_BATCH) {
+            size_t count = std::min(FIND_BATCH, n - begin);
+            for (size_t i = 0; i < count; ++i) {
+                pos[i] = home(keys[begin + i]);
+                __builtin_prefetch(distance + pos[i]);
+                __builtin_prefetch(array + pos[i]);
+            }
+            for (size_t i = 0; i < count; ++i) {
+                results[begin + i] = probe(keys[begin + i], pos[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief Insert x, repetition makes no operations
+     */
+    void insert(const set<Key, Other> &x) {
+        if (find(x.key) != nullptr) {
+            // we have insert the same key value!
+            return;
+        }
+        if (element_count + 1 > max_load * slot_count) {
+            rehash(slot_count * 2);
+        }
+        // a run too long to join: growing splits it, unless it is made of keys with the same key(x),
+        // and a table already sparse is not grown further
+        size_t same;
+        for (int growth = 0; !fits(x.key, same); ++growth) {
+            if (growth == MAX_GROWTH || same + 1 >= MAX_DISTANCE - 1 || element_count < slot_count / 8) {
+                throw std::runtime_error("Too many keys with the same hash value!");
+            }
+            rehash(slot_count * 2);
+        }
+        place(x);
+        ++element_count;
+    }
+
+    /**
+     * @brief Remove x, the elements after it in the run move one slot back (backward shift),
+     * so no tombstone is left
+     */
+    void remove(const Key &x) {
+        set<Key, Other> *found = find(x);
+        if (found == nullptr) {
+            // no element will be deleted
+            return;
+        }
+        size_t pos = found - array, next = (pos + 1) & mask;
+        while (distance[next] > 1) {
+            array[pos] = std::move(array[next]);
+            distance[pos] = distance[next] - 1;
+            pos = next;
+            next = (next + 1) & mask;
+        }
+        distance[pos] = 0;
+        array[pos] = set<Key, Other>();
+        --element_count;
+    }
+
+    /**
+     * @brief the number of elements
+     */
+    size_t size() const {
+        return element_count;
+    }
+
+    /**
+     * @brief the number of slots
+     */
+    size_t capacity() const {
+        return slot_count;
+    }
+
+    /**
+     * @brief the mean number of slots a successful lookup probes
+     */
+    double averageProbe() const {
+        size_t total = 0;
+        for (size_t i = 0; i < slot_count; ++i) {
+            total += distance[i];
+        }
+        return element_count == 0 ? 0 : double(total) / element_count;
+    }
 };
 
+#ifndef BENCHMARK_NO_MAIN
+int generate_random(int range = 100000) {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<> dis(1, range);
+    return dis(gen);
+}
+
+std::string generate_random_string(size_t length = 20) {
+    const std::string characters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<> dis(0, characters.size() - 1);
+
+    std::string random_string;
+    for (size_t i = 0; i < length; ++i) {
+        random_string += characters[dis(gen)];
+    }
+    return random_string;
+}
+
+
+// The previous close_Hash_Table: linear probing in a fixed size array with tombstones (status 2),
+// kept as the baseline of the benchmark below
 template<class Key, class Other>
-class close_Hash_Table : public dynamicSearchTable<Key, Other> {
+class tombstone_Hash_Table : public dynamicSearchTable<Key, Other> {
 private:
     struct Node {
         set<Key, Other> data;
@@ -60,19 +317,11 @@ private:
         return x;
     }
 
-public:
-    close_Hash_Table(int length = 101, int (*f)(const Key &x) = defaultKey) {
-        size = length;
-        array = new Node[size];
-        key = f;
-    }
-    ~close_Hash_Table() {
-        delete[] array;
-    }
-
-    set<Key, Other> *find(const Key &x) const {
-        int init_pos, pos;
-        pos = init_pos = key(x) % size;
+    /**
+     * @brief Linear probing for x from init_pos
+     */
+    set<Key, Other> *probe(const Key &x, int init_pos) const {
+        int pos = init_pos;
         do {
             if (array[pos].status == 0) {
                 return nullptr;
@@ -89,6 +338,20 @@ public:
         return nullptr;
     }
 
+public:
+    tombstone_Hash_Table(int length = 101, int (*f)(const Key &x) = defaultKey) {
+        size = length;
+        array = new Node[size];
+        key = f;
+    }
+    ~tombstone_Hash_Table() {
+        delete[] array;
+    }
+
+    set<Key, Other> *find(const Key &x) const {
+        return probe(x, key(x) % size);
+    }
+
     void insert(const set<Key, Other> &x) {
         int init_pos, pos;
 
@@ -132,60 +395,126 @@ public:
     }
 };
 
-int generate_random(int range = 100000) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(1, range);
-    return dis(gen);
-}
-
-std::string generate_random_string(size_t length = 20) {
-    const std::string characters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, characters.size() - 1);
-
-    std::string random_string;
-    for (size_t i = 0; i < length; ++i) {
-        random_string += characters[dis(gen)];
-    }
-    return random_string;
-}
-
+// the operations of the original demo workload, generated up front so only the table is timed
+struct operation {
+    int type;// 0 for insert, 1 for find, 2 for remove
+    int key;
+};
 
-int main() {
-    close_Hash_Table<int, std::string> s(10000);
+/**
+ * @brief The original main: insert alldata_num random keys, then query_num random finds, each followed
+ * by the removal of the oldest key with probability 1/3. With churn, every removed key is replaced by
+ * a new random one, so the table stays at the same load.
+ */
+std::vector<operation> demoWorkload(long long alldata_num, long long query_num, bool churn) {
     long long alldata_range = 1000000000;
-    long long alldata_num = 8000;
-    long long query_num = 1000000;
-    set<int, std::string> element;
+    std::mt19937 gen(2025);
+    std::uniform_int_distribution<> dis(1, alldata_range);
+    std::vector<operation> operations;
     std::queue<int> storage;
+    for (long long i = 0; i < alldata_num; i++) {
+        operations.push_back({0, dis(gen)});
+        storage.push(operations.back().key);
+    }
+    for (long long i = 0; i < query_num; i++) {
+        operations.push_back({1, dis(gen)});
+        if (gen() % 3 == 0 && !storage.empty()) {
+            operations.push_back({2, storage.front()});
+            storage.pop();
+            if (churn) {
+                operations.push_back({0, dis(gen)});
+                storage.push(operations.back().key);
+            }
+        }
+    }
+    return operations;
+}
 
-    for (int i = 0; i < alldata_num; i++) {
-        set<int, std::string> element;
-        element.key = generate_random(alldata_range);
-        element.other = generate_random_string();
-        s.insert(element);
-        storage.push(element.key);
+/**
+ * @brief Run the operations and return the time in ms, found counts the successful finds
+ */
+template<class Table>
+double run(Table &table, const std::vector<operation> &operations, long long &found) {
+    found = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const operation &op : operations) {
+        if (op.type == 0) {
+            table.insert({op.key, op.key});
+        } else if (op.type == 1) {
+            found += table.find(op.key) != nullptr;
+        } else {
+            table.remove(op.key);
+        }
     }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count();
+}
 
-    // for the searching period
-    for (int i = 0; i < query_num; i++) {
-        int search_key = generate_random(alldata_range);
-        if (s.find(search_key) != nullptr) {
-            std::cout << "Find the key value " << search_key << std::endl;
+int main(int argc, char *argv[]) {
+    std::cout << "--- close_Hash_Table Tests ---" << std::endl;
+    close_Hash_Table<int, std::string> s(4);
+    s.insert({10, "Ten"});
+    s.insert({18, "Eighteen"});
+    s.insert({26, "Twenty-six"});
+    s.remove(18);
+    auto result = s.find(26);
+    std::cout << "find(26): " << (result ? result->other : "not found") << ", find(18): "
+              << (s.find(18) ? "found" : "not found") << " (Expected: Twenty-six, not found)" << std::endl;
+
+    // random operations against std::unordered_map, growing from 8 slots
+    std::mt19937 gen(2025);
+    close_Hash_Table<int, int> checked(8, [](const int &x) { return x; }, 0.9);
+    std::unordered_map<int, int> expected;
+    bool pass = true;
+    for (int i = 0; i < 1000000 && pass; ++i) {
+        int key = gen() % 20000, op = gen() % 3;
+        if (op == 0) {
+            checked.insert({key, i});
+            expected.emplace(key, i);
+        } else if (op == 1) {
+            checked.remove(key);
+            expected.erase(key);
+        } else {
+            auto it = expected.find(key);
+            set<int, int> *x = checked.find(key);
+            pass = (it == expected.end()) ? x == nullptr : (x != nullptr && x->other == it->second);
         }
+        pass = pass && checked.size() == expected.size();
+    }
+    std::cout << "Random operations: " << (pass ? "PASS" : "FAIL") << ", " << checked.size() << " elements in "
+              << checked.capacity() << " slots, average probe " << checked.averageProbe() << std::endl;
 
-        if (generate_random(1000) % 3 == 0 && !storage.empty()) {
-            // randomly remove some elements
-            int dele = storage.front();
-            s.remove(dele);
-            if (s.find(dele) == nullptr) {
-                std::cout << "The key value " << dele << " has been deleted successfully." << std::endl;
-            }
-            storage.pop();
+    // two groups of keys with colliding key(x) values: a failed insert leaves the table as it was
+    close_Hash_Table<int, int> colliding(8, [](const int &x) { return x % 2 == 0 ? 0 : 1597; });
+    int inserted = 0;
+    try {
+        for (; inserted < 1000; ++inserted) {
+            colliding.insert({inserted, inserted});
         }
+    } catch (const std::runtime_error &e) {
+        std::cout << "Colliding keys: " << e.what() << " at key " << inserted;
     }
+    pass = colliding.size() == size_t(inserted) && colliding.capacity() < 16 * colliding.size();
+    for (int i = 0; i < inserted; ++i) {
+        pass = pass && colliding.find(i) != nullptr;
+    }
+    std::cout << ", " << colliding.size() << " elements in " << colliding.capacity() << " slots, all found: "
+              << (pass ? "PASS" : "FAIL") << std::endl;
 
+    // usage: close_Hash_Table [query_num]
+    long long query_num = argc > 1 ? std::stoll(argv[1]) : 1000000;
+    std::cout << "\n--- Benchmark: the demo workload, 8000 keys in 10000 slots, " << query_num << " finds ---" << std::endl;
+    for (bool churn : {false, true}) {
+        std::vector<operation> operations = demoWorkload(8000, query_num, churn);
+        long long old_found, new_found;
+        tombstone_Hash_Table<int, int> old_table(10000);
+        close_Hash_Table<int, int> new_table(10000);
+        double old_time = run(old_table, operations, old_found);
+        double new_time = run(new_table, operations, new_found);
+        std::cout << (churn ? "With churn (a new key for every removed one): " : "Removals only: ") << operations.size()
+                  << " operations, tombstones " << old_time << " ms, Robin Hood " << new_time << " ms, "
+                  << (old_found == new_found ? "PASS" : "FAIL") << std::endl;
+    }
     return 0;
 }
+#endif
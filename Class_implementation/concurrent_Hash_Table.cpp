@@ -0,0 +1,510 @@
+/*
+The implementation of a thread-safe separate chaining hash table: the chains of open_Hash_Table with
+atomic links, so that many threads can share one table.
+Writers lock one of STRIPES spinlocks, each of which protects every bucket whose index has the same low
+bits, so writers to different stripes never wait for each other. find takes no lock at all: it walks
+the chain with acquire loads, removed nodes and old bucket arrays are freed by epoch-based reclamation
+once no reader can see them, and a resize stops the writers (it takes every stripe) and relinks the
+nodes in place while readers retry any miss that overlapped it.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "epochDomain.hpp"
+
+#define BENCHMARK_NO_MAIN
+#include "open_Hash_Table.cpp"
+#undef BENCHMARK_NO_MAIN
+
+template<class Key, class Other, class Hash = std::hash<Key>>
+class concurrent_Hash_Table {
+private:
+    static const size_t STRIPES = 128;
+
+    struct nodePool;
+
+    struct Node {
+        set<Key, Other> data;
+        std::atomic<Node *> next;
+        size_t hash;
+        nodePool *pool;
+        Node(const set<Key, Other> &d, Node *n, size_t h, nodePool *p) : data(d), next(n), hash(h), pool(p) {}
+
+        // the deleter of a retired node: no reader can see it any more, its memory goes back to its stripe
+        static void recycle(void *p) {
+            Node *node = static_cast<Node *>(p);
+            nodePool *pool = node->pool;
+            size_t stripe_index = node->hash & (STRIPES - 1);
+            node->~Node();
+            pool->giveBack(stripe_index, node);
+            pool->release();
+        }
+    };
+
+    /*
+    The slabs of open_Hash_Table's NodePool, one shelf per stripe: a node is made under the lock of its
+    stripe, which is fixed by its hash, so the free list needs no other lock. A retired node comes back
+    on the lock-free returned stack of its shelf (push only, and the owner takes the whole stack, so no ABA),
+    and the pool lives until the table and every node retired from it are gone.
+    */
+    struct nodePool {
+        static const size_t MIN_SLAB = 16;
+        static const size_t MAX_SLAB = 4096;
+
+        // a free node, its storage holds the next free one
+        struct FreeNode {
+            FreeNode *next;
+        };
+
+        struct alignas(64) shelf {
+            std::vector<void *> slabs;
+            FreeNode *free_list = nullptr;
+            char *current = nullptr;// the unused part of the last slab
+            size_t remaining = 0;
+            std::atomic<FreeNode *> returned{nullptr};
+        };
+
+        shelf shelves[STRIPES];
+        std::atomic<size_t> references{1};// the table and the retired nodes
+
+        ~nodePool() {
+            for (shelf &s : shelves) {
+                for (void *slab : s.slabs) {
+                    ::operator delete(slab);
+                }
+            }
+        }
+
+        // the caller holds the lock of stripe_index
+        Node *create(size_t stripe_index, const set<Key, Other> &d, Node *n, size_t h) {
+            shelf &s = shelves[stripe_index];
+            if (s.free_list == nullptr) {
+                s.free_list = s.returned.exchange(nullptr, std::memory_order_acquire);
+            }
+            void *memory;
+            if (s.free_list != nullptr) {
+                memory = s.free_list;
+                s.free_list = s.free_list->next;
+            } else {
+                if (s.remaining == 0) {
+                    s.remaining = std::min(MAX_SLAB, MIN_SLAB << std::min<size_t>(s.slabs.size(), 8));
+                    s.current = static_cast<char *>(::operator new(s.remaining * sizeof(Node)));
+                    s.slabs.push_back(s.current);
+                }
+                memory = s.current;
+                s.current += sizeof(Node);
+                --s.remaining;
+            }
+            return new (memory) Node(d, n, h, this);
+        }
+
+        void giveBack(size_t stripe_index, void *memory) {
+            std::atomic<FreeNode *> &returned = shelves[stripe_index].returned;
+            FreeNode *node = static_cast<FreeNode *>(memory);
+            node->next = returned.load(std::memory_order_relaxed);
+            while (!returned.compare_exchange_weak(node->next, node, std::memory_order_release,
+                                                   std::memory_order_relaxed)) {}
+        }
+
+        void release() {
+            if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete this;
+            }
+        }
+    };
+
+    struct bucketArray {
+        size_t size;// a power of two, at least STRIPES
+        std::atomic<Node *> *buckets;
+
+        explicit bucketArray(size_t size_) : size(size_), buckets(new std::atomic<Node *>[size_]) {
+            for (size_t i = 0; i < size; ++i) {
+                buckets[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        ~bucketArray() {
+            delete[] buckets;
+        }
+
+        static void destroy(void *p) {
+            delete static_cast<bucketArray *>(p);
+        }
+    };
+
+    // spins on a held lock before giving the core to another thread
+    static const int SPIN_LIMIT = 64;
+
+    // a spinlock and the number of elements in the buckets it protects, one cache line each
+    struct alignas(64) stripe {
+        std::atomic<bool> locked{false};
+        size_t count = 0;
+
+        void lock() {
+            while (locked.exchange(true, std::memory_order_acquire)) {
+                for (int spin = 0; locked.load(std::memory_order_relaxed); ++spin) {
+                    if (spin >= SPIN_LIMIT) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        }
+
+        void unlock() {
+            locked.store(false, std::memory_order_release);
+        }
+    };
+
+    stripe stripes[STRIPES];
+    nodePool *pool;
+    std::atomic<bucketArray *> table;
+    // odd while a resize relinks the nodes, a miss seen across a change may be wrong
+    std::atomic<uint64_t> version;
+    double max_chain;
+    Hash hasher;
+
+    // the buckets are chosen by the low bits, which the hash functor (identity for integers) leaves poor
+    size_t hashOf(const Key &x) const {
+        uint64_t h = uint64_t(hasher(x)) * 0x9E3779B97F4A7C15ull;
+        return size_t(h ^ (h >> 32));
+    }
+
+    stripe &stripeOf(size_t h) {
+        return stripes[h & (STRIPES - 1)];
+    }
+
+    /**
+     * @brief Double the buckets if they still number observed: stop every writer, relink every node
+     * into the new array, publish it, and retire the old one
+     */
+    void resize(size_t observed) {
+        for (stripe &s : stripes) {
+            s.lock();
+        }
+        bucketArray *old = table.load(std::memory_order_relaxed);
+        if (old->size == observed) {
+            bucketArray *t = new bucketArray(old->size * 2);
+            version.fetch_add(1, std::memory_order_seq_cst);
+            for (size_t i = 0; i < old->size; ++i) {
+                Node *p = old->buckets[i].load(std::memory_order_relaxed);
+                while (p != nullptr) {
+                    Node *q = p->next.load(std::memory_order_relaxed);
+                    std::atomic<Node *> &head = t->buckets[p->hash & (t->size - 1)];
+                    p->next.store(head.load(std::memory_order_relaxed), std::memory_order_release);
+                    head.store(p, std::memory_order_relaxed);
+                    p = q;
+                }
+            }
+            table.store(t, std::memory_order_release);
+            version.fetch_add(1, std::memory_order_release);
+            epochDomain::retire(old, &bucketArray::destroy);
+        }
+        for (stripe &s : stripes) {
+            s.unlock();
+        }
+    }
+
+public:
+    /**
+     * @brief Construct a new concurrent_Hash_Table object
+     *
+     * @param size_ the initial number of buckets, rounded up to a power of two of at least STRIPES
+     * @param max_chain_ the buckets double when the average chain length of a stripe would exceed it
+     * @param hasher_ the hash functor
+     */
+    explicit concurrent_Hash_Table(size_t size_ = 101, double max_chain_ = 1.0, const Hash &hasher_ = Hash())
+        : pool(new nodePool), version(0), max_chain(max_chain_), hasher(hasher_) {
+        if (!(max_chain > 0)) {
+            throw std::invalid_argument("The max chain length should be positive!");
+        }
+        size_t count = STRIPES;
+        while (count < size_) {
+            count *= 2;
+        }
+        table.store(new bucketArray(count), std::memory_order_release);
+    }
+
+    /**
+     * @brief no other thread may use the table any more
+     */
+    ~concurrent_Hash_Table() {
+        bucketArray *t = table.load(std::memory_order_acquire);
+        for (size_t i = 0; i < t->size; ++i) {
+            Node *p = t->buckets[i].load(std::memory_order_relaxed);
+            while (p != nullptr) {
+                Node *q = p->next.load(std::memory_order_relaxed);
+                p->~Node();
+                p = q;
+            }
+        }
+        delete t;
+        pool->release();
+    }
+
+    concurrent_Hash_Table(const concurrent_Hash_Table &) = delete;
+    concurrent_Hash_Table &operator=(const concurrent_Hash_Table &) = delete;
+
+    /**
+     * @brief Lock-free lookup. The element stays valid while the calling thread holds an epochGuard.
+     *
+     * @return set<Key, Other>* nullptr if x is not in the table
+     */
+    set<Key, Other> *find(const Key &x) const {
+        size_t h = hashOf(x);
+        while (true) {
+            uint64_t v = version.load(std::memory_order_acquire);
+            if (v & 1) {
+                // a resize is relinking the nodes
+                std::this_thread::yield();
+                continue;
+            }
+            bucketArray *t = table.load(std::memory_order_acquire);
+            for (Node *p = t->buckets[h & (t->size - 1)].load(std::memory_order_acquire); p != nullptr;
+                 p = p->next.load(std::memory_order_acquire)) {
+                if (p->hash == h && p->data.key == x) {
+                    return &p->data;
+                }
+            }
+            // a node moved by a resize meanwhile could have been skipped
+            if (version.load(std::memory_order_acquire) == v) {
+                return nullptr;
+            }
+        }
+    }
+
+    /**
+     * @brief Lock-free membership test, no epochGuard needed
+     */
+    bool contains(const Key &x) const {
+        epochGuard guard;
+        return find(x) != nullptr;
+    }
+
+    /**
+     * @brief Insert x if its key is not in the table yet
+     *
+     * @return true if x was inserted, false if the key was already there
+     */
+    bool insert(const set<Key, Other> &x) {
+        size_t h = hashOf(x.key);
+        stripe &s = stripeOf(h);
+        s.lock();
+        // a resize needs every stripe, so the bucket array stays while we hold one
+        bucketArray *t = table.load(std::memory_order_acquire);
+        std::atomic<Node *> &head = t->buckets[h & (t->size - 1)];
+        for (Node *p = head.load(std::memory_order_relaxed); p != nullptr; p = p->next.load(std::memory_order_relaxed)) {
+            if (p->hash == h && p->data.key == x.key) {
+                s.unlock();
+                return false;
+            }
+        }
+        // only a new key costs an allocation, a duplicate leaves at the search above
+        head.store(pool->create(h & (STRIPES - 1), x, head.load(std::memory_order_relaxed), h),
+                   std::memory_order_release);
+        size_t size = t->size;
+        bool grow = ++s.count > max_chain * size / STRIPES;
+        s.unlock();
+        if (grow) {
+            resize(size);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Remove the element with key x, the node is freed once no reader can see it
+     *
+     * @return true if x was in the table
+     */
+    bool remove(const Key &x) {
+        size_t h = hashOf(x);
+        stripe &s = stripeOf(h);
+        s.lock();
+        bucketArray *t = table.load(std::memory_order_acquire);
+        std::atomic<Node *> *link = &t->buckets[h & (t->size - 1)];
+        for (Node *p = link->load(std::memory_order_relaxed); p != nullptr; p = link->load(std::memory_order_relaxed)) {
+            if (p->hash == h && p->data.key == x) {
+                // readers on p still go on through its next
+                link->store(p->next.load(std::memory_order_relaxed), std::memory_order_release);
+                --s.count;
+                s.unlock();
+                pool->references.fetch_add(1, std::memory_order_relaxed);
+                epochDomain::retire(p, &Node::recycle);
+                return true;
+            }
+            link = &p->next;
+        }
+        s.unlock();
+        return false;
+    }
+
+    /**
+     * @brief the number of elements, exact only when no insert or remove is running
+     */
+    size_t size() {
+        size_t total = 0;
+        for (stripe &s : stripes) {
+            s.lock();
+            total += s.count;
+            s.unlock();
+        }
+        return total;
+    }
+
+    /**
+     * @brief the number of buckets
+     */
+    size_t bucketCount() const {
+        return table.load(std::memory_order_acquire)->size;
+    }
+};
+
+#ifndef BENCHMARK_NO_MAIN
+// the single mutex around open_Hash_Table which the striped table replaces
+template<class Key>
+class lockedHashTable {
+private:
+    open_Hash_Table<Key, int> table;
+    mutable std::mutex mtx;
+
+public:
+    bool insert(const Key &x) {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (table.find(x) != nullptr) {
+            return false;
+        }
+        table.insert({x, 0});
+        return true;
+    }
+
+    bool contains(const Key &x) const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return table.find(x) != nullptr;
+    }
+};
+
+/**
+ * @brief Every thread runs through its own keys: read_percent of them are lookups and the others
+ * insert the key if it is absent (deduplication). Returns Mops/s.
+ */
+template<class Key, class Insert, class Lookup>
+double sharedThroughput(const std::vector<std::vector<Key>> &keys, int read_percent, Insert insert, Lookup lookup) {
+    std::atomic<size_t> hits{0};// keeps the compiler from dropping the lookups
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < keys.size(); ++t) {
+        pool.emplace_back([&, t]() {
+            size_t found = 0;
+            for (size_t i = 0; i < keys[t].size(); ++i) {
+                if (int(i % 100) < read_percent) {
+                    found += lookup(keys[t][i]);
+                } else {
+                    found += insert(keys[t][i]);
+                }
+            }
+            hits.fetch_add(found);
+        });
+    }
+    for (auto &thread : pool) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return keys.size() * keys[0].size() / elapsed.count() / 1e6;
+}
+
+/**
+ * @brief The striped table against the mutex, with 1, 2, 4, ... max_threads threads,
+ * key(t) makes the keys of thread t
+ */
+template<class Key, class Generator>
+void compare(const std::string &name, size_t max_threads, size_t ops, Generator key) {
+    for (int read_percent : {90, 0}) {
+        std::cout << "\n--- " << name << " keys, " << read_percent << "% lookups, " << ops
+                  << " operations per thread (Mops/s) ---" << std::endl;
+        for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+            std::vector<std::vector<Key>> keys(threads);
+            for (size_t t = 0; t < threads; ++t) {
+                for (size_t i = 0; i < ops; ++i) {
+                    keys[t].push_back(key(t));
+                }
+            }
+            concurrent_Hash_Table<Key, int> striped;
+            lockedHashTable<Key> locked;
+            double striped_rate = sharedThroughput(
+                    keys, read_percent, [&striped](const Key &x) { return striped.insert({x, 0}); },
+                    [&striped](const Key &x) { return striped.contains(x); });
+            double locked_rate = sharedThroughput(
+                    keys, read_percent, [&locked](const Key &x) { return locked.insert(x); },
+                    [&locked](const Key &x) { return locked.contains(x); });
+            std::cout << threads << " threads: striped " << striped_rate << ", mutex + open_Hash_Table " << locked_rate
+                      << std::endl;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "--- concurrent_Hash_Table Tests ---" << std::endl;
+    concurrent_Hash_Table<std::string, int> s;
+    s.insert({"Ten", 10});
+    s.insert({"Eighteen", 18});
+    bool again = s.insert({"Ten", 100});
+    s.remove("Eighteen");
+    {
+        epochGuard guard;
+        auto result = s.find("Ten");
+        std::cout << "find(Ten): " << (result ? std::to_string(result->other) : "not found") << ", find(Eighteen): "
+                  << (s.find("Eighteen") ? "found" : "not found") << ", insert Ten again: " << again
+                  << " (Expected: 10, not found, 0)" << std::endl;
+    }
+
+    // every thread owns the keys k with k % threads == t: inserts all, removes the odd ones, while
+    // checking that its earlier keys are still found through the resizes
+    {
+        const int threads = 4, per_thread = 200000;
+        concurrent_Hash_Table<int, int> shared(1);
+        std::atomic<bool> pass{true};
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([&shared, &pass, t]() {
+                for (int i = 0; i < per_thread; ++i) {
+                    int key = i * threads + t;
+                    shared.insert({key, key});
+                    if (i % 2 == 1) {
+                        shared.remove(key);
+                    }
+                    int earlier = (i - i % 2) * threads + t;// the last even i, still in the table
+                    epochGuard guard;
+                    set<int, int> *x = shared.find(earlier);
+                    if (x == nullptr || x->other != earlier || (i % 2 == 1 && shared.find(key) != nullptr)) {
+                        pass = false;
+                    }
+                }
+            });
+        }
+        for (auto &thread : pool) {
+            thread.join();
+        }
+        bool content = shared.size() == size_t(threads * per_thread / 2);
+        for (int key = 0; key < threads * per_thread && content; ++key) {
+            content = shared.contains(key) == ((key / threads) % 2 == 0);
+        }
+        std::cout << "Concurrent insert / remove / find: " << (pass && content ? "PASS" : "FAIL") << ", "
+                  << shared.size() << " elements in " << shared.bucketCount() << " buckets" << std::endl;
+    }
+
+    // usage: concurrent_Hash_Table [max threads] [operations per thread]
+    size_t max_threads = argc > 1 ? std::stoull(argv[1]) : std::max<unsigned>(4, std::thread::hardware_concurrency());
+    size_t ops = argc > 2 ? std::stoull(argv[2]) : 1000000;
+    compare<int>("random int", max_threads, ops, [](size_t) { return generate_random(10000000); });
+    compare<std::string>("random string", max_threads, ops, [](size_t) { return generate_random_string(); });
+    return 0;
+}
+#endif
@@ -0,0 +1,460 @@
+/*
+The implementation of a bucketized cuckoo hash table: every key has two candidate buckets of 8 slots,
+so a lookup reads at most two buckets, whatever the load. Every slot has an 8-bit tag (a few bits of
+the hash, 0 for empty), the 16 tags of both buckets are compared with the tag of the key in one SSE2
+instruction, and only the slots whose tag matches compare keys. An insert into two full buckets searches
+breadth first for the shortest chain of elements to move to their other bucket, and the table doubles
+when no chain is found.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "batchLookup.hpp"
+#include "dynamicSearchTable.hpp"
+
+template<class Key, class Other>
+class cuckoo_Hash_Table : public dynamicSearchTable<Key, Other> {
+private:
+    static const int SLOTS = 8;// slots per bucket
+    // the breadth first search for a free slot gives up after this many buckets
+    static const int MAX_SEARCH = 512;
+    // the doublings one insert may make to fit an element, before it gives up
+    static const int MAX_GROWTH = 3;
+
+    // the tags of bucket b are tags[b * SLOTS, (b + 1) * SLOTS), apart from the elements,
+    // so that a miss usually reads two tag words and no element
+    uint8_t *tags;
+    set<Key, Other> *array;
+    size_t bucket_count;// a power of two
+    size_t mask;
+    size_t element_count;
+
+    // function pointer (hash function)
+    int (*key)(const Key &x);
+
+    // if the key value is int iteself, we no need for another function
+    static int defaultKey(const int &x) {
+        return x;
+    }
+
+    // the two buckets and the tag of a key
+    struct position {
+        size_t first, second;
+        uint8_t tag;
+    };
+
+    position locate(const Key &x) const {
+        uint64_t h = uint64_t(uint32_t(key(x))) * 0x9E3779B97F4A7C15ull;
+        h ^= h >> 29;
+        h *= 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 32;
+        position pos;
+        pos.first = h & mask;
+        pos.second = (h >> 24) & mask;
+        if (pos.second == pos.first) {
+            pos.second = pos.first ^ 1;
+        }
+        pos.tag = uint8_t(h >> 56) | 1;// tags are never 0
+        return pos;
+    }
+
+    /**
+     * @brief The slots of the two buckets (bits 0-7 for first, 8-15 for second) whose tag equals tag
+     */
+    unsigned matchTags(size_t first, size_t second, uint8_t tag) const {
+#ifdef __SSE2__
+        uint64_t low, high;
+        std::memcpy(&low, tags + first * SLOTS, SLOTS);
+        std::memcpy(&high, tags + second * SLOTS, SLOTS);
+        __m128i both = _mm_set_epi64x(int64_t(high), int64_t(low));
+        return unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(both, _mm_set1_epi8(char(tag)))));
+#else
+        unsigned result = 0;
+        for (int i = 0; i < SLOTS; ++i) {
+            result |= unsigned(tags[first * SLOTS + i] == tag) << i;
+            result |= unsigned(tags[second * SLOTS + i] == tag) << (i + SLOTS);
+        }
+        return result;
+#endif
+    }
+
+    set<Key, Other> *probe(const Key &x, const position &pos) const {
+        unsigned match = matchTags(pos.first, pos.second, pos.tag);
+        while (match != 0) {
+            int bit = __builtin_ctz(match);
+            size_t slot = (bit < SLOTS ? pos.first : pos.second) * SLOTS + (bit & (SLOTS - 1));
+            if (array[slot].key == x) {
+                return array + slot;
+            }
+            match &= match - 1;
+        }
+        return nullptr;
+    }
+
+    // the first empty slot of a bucket, -1 if full
+    int emptySlot(size_t bucket) const {
+        for (int i = 0; i < SLOTS; ++i) {
+            if (tags[bucket * SLOTS + i] == 0) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void allocate(size_t count) {
+        bucket_count = count;
+        mask = count - 1;
+        tags = new uint8_t[bucket_count * SLOTS]();
+        array = new set<Key, Other>[bucket_count * SLOTS];
+    }
+
+    // a bucket of the breadth first search, which remembers the slot of its parent whose element would move into it
+    struct visit {
+        size_t bucket;
+        int parent;
+        int from_slot;
+    };
+
+    // whether bucket is on the path from queue[index] back to its root, a path moves every slot at most once
+    static bool onPath(const std::vector<visit> &queue, int index, size_t bucket) {
+        for (; index >= 0; index = queue[index].parent) {
+            if (queue[index].bucket == bucket) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Put x, which is not in the table, into one of its buckets, moving other elements to their
+     * other bucket along the shortest path found by a breadth first search
+     *
+     * @return false if no path was found within MAX_SEARCH buckets
+     */
+    bool place(set<Key, Other> &x) {
+        position pos = locate(x.key);
+        for (size_t bucket : {pos.first, pos.second}) {
+            int slot = emptySlot(bucket);
+            if (slot >= 0) {
+                tags[bucket * SLOTS + slot] = pos.tag;
+                array[bucket * SLOTS + slot] = std::move(x);
+                return true;
+            }
+        }
+
+        std::vector<visit> queue{{pos.first, -1, -1}, {pos.second, -1, -1}};
+        for (size_t head = 0; head < queue.size() && queue.size() < size_t(MAX_SEARCH); ++head) {
+            size_t bucket = queue[head].bucket;
+            for (int i = 0; i < SLOTS; ++i) {
+                position moved = locate(array[bucket * SLOTS + i].key);
+                size_t other = moved.first == bucket ? moved.second : moved.first;
+                int slot = emptySlot(other);
+                if (slot < 0) {
+                    if (!onPath(queue, int(head), other)) {
+                        queue.push_back({other, int(head), i});
+                    }
+                    continue;
+                }
+                // found a free slot: move the elements along the path, from its end to its start
+                size_t to = other * SLOTS + slot, from = bucket * SLOTS + i;
+                int current = int(head);
+                while (true) {
+                    tags[to] = tags[from];
+                    array[to] = std::move(array[from]);
+                    to = from;
+                    if (queue[current].parent < 0) {
+                        break;
+                    }
+                    from = queue[queue[current].parent].bucket * SLOTS + queue[current].from_slot;
+                    current = queue[current].parent;
+                }
+                tags[to] = pos.tag;
+                array[to] = std::move(x);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the elements in the two buckets of x whose key(x) is the same as the one of x
+    int sameKey(const Key &x) const {
+        position pos = locate(x);
+        int same = 0;
+        for (size_t bucket : {pos.first, pos.second}) {
+            for (int i = 0; i < SLOTS; ++i) {
+                size_t slot = bucket * SLOTS + i;
+                same += tags[slot] != 0 && key(array[slot].key) == key(x);
+            }
+        }
+        return same;
+    }
+
+    /**
+     * @brief Move the elements to a table of count buckets
+     *
+     * @return false, with the table as it was, if an element finds no place in the new table
+     */
+    bool rehash(size_t count) {
+        uint8_t *old_tags = tags;
+        set<Key, Other> *old_array = array;
+        size_t old_count = bucket_count;
+        allocate(count);
+        for (size_t i = 0; i < old_count * SLOTS; ++i) {
+            if (old_tags[i] == 0) {
+                continue;
+            }
+            // a copy, so that the old table is still whole if the new one has to be dropped
+            set<Key, Other> element = old_array[i];
+            if (!place(element)) {
+                delete[] tags;
+                delete[] array;
+                tags = old_tags;
+                array = old_array;
+                bucket_count = old_count;
+                mask = old_count - 1;
+                return false;
+            }
+        }
+        delete[] old_tags;
+        delete[] old_array;
+        return true;
+    }
+
+public:
+    /**
+     * @brief Construct a new cuckoo_Hash_Table object
+     *
+     * @param length the initial number of slots, rounded up to a power of two buckets of 8 slots
+     * @param f the hash function
+     */
+    cuckoo_Hash_Table(int length = 101, int (*f)(const Key &x) = defaultKey) {
+        size_t count = 2;
+        while (count * SLOTS < size_t(std::max(length, 1))) {
+            count *= 2;
+        }
+        allocate(count);
+        element_count = 0;
+        key = f;
+    }
+    ~cuckoo_Hash_Table() {
+        delete[] tags;
+        delete[] array;
+    }
+
+    cuckoo_Hash_Table(const cuckoo_Hash_Table &) = delete;
+    cuckoo_Hash_Table &operator=(const cuckoo_Hash_Table &) = delete;
+
+    set<Key, Other> *find(const Key &x) const {
+        return probe(x, locate(x));
+    }
+
+    /**
+     * @brief results[i] = find(keys[i]) for i in [0, n).
+     * The keys are hashed FIND_BATCH at a time, and the tags of both buckets of every key are prefetched
+     * before any of them is matched.
+     */
+    void find_batch(const Key *keys, size_t n, set<Key, Other> **results) const {
+        position pos[FIND_BATCH];
+        for (size_t begin = 0; begin < n; begin += FIND_BATCH) {
+            size_t count = std::min(FIND_BATCH, n - begin);
+            for (size_t i = 0; i < count; ++i) {
+                pos[i] = locate(keys[begin + i]);
+                __builtin_prefetch(tags + pos[i].first * SLOTS);
+                __builtin_prefetch(tags + pos[i].second * SLOTS);
+            }
+            for (size_t i = 0; i < count; ++i) {
+                results[begin + i] = probe(keys[begin + i], pos[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief Insert x, repetition makes no operations
+     */
+    void insert(const set<Key, Other> &x) {
+        if (find(x.key) != nullptr) {
+            // we have insert the same key value!
+            return;
+        }
+        // no chain found: grow, unless both buckets hold keys with the same key(x), which no size
+        // can separate, and a table already sparse is not grown further
+        set<Key, Other> element = x;
+        for (int growth = 0; !place(element); ++growth) {
+            if (growth == MAX_GROWTH || sameKey(element.key) == 2 * SLOTS || element_count < capacity() / 8) {
+                throw std::runtime_error("Too many keys with the same hash value!");
+            }
+            rehash(bucket_count * 2);
+        }
+        ++element_count;
+    }
+
+    void remove(const Key &x) {
+        set<Key, Other> *found = find(x);
+        if (found == nullptr) {
+            // no element will be deleted
+            return;
+        }
+        size_t slot = found - array;
+        tags[slot] = 0;
+        array[slot] = set<Key, Other>();
+        --element_count;
+    }
+
+    /**
+     * @brief the number of elements
+     */
+    size_t size() const {
+        return element_count;
+    }
+
+    /**
+     * @brief the number of slots
+     */
+    size_t capacity() const {
+        return bucket_count * SLOTS;
+    }
+};
+
+#ifndef BENCHMARK_NO_MAIN
+#define BENCHMARK_NO_MAIN
+#include "close_Hash_Table.cpp"
+#include "open_Hash_Table.cpp"
+#undef BENCHMARK_NO_MAIN
+
+// a bijection of the 32-bit integers, so that hit(i) for different i are different keys
+int hit(uint32_t i) {
+    i ^= i >> 16;
+    i *= 0x85EBCA6Bu;
+    i ^= i >> 13;
+    i *= 0xC2B2AE35u;
+    i ^= i >> 16;
+    return int(i);
+}
+
+/**
+ * @brief Time the inserts of keys, then the finds of the positive (inserted) and negative (missing) keys,
+ * capacity() is the number of slots (or buckets) after the inserts
+ */
+template<class Table, class Capacity>
+void measure(const std::string &name, Table &table, const std::vector<int> &keys, const std::vector<int> &positive,
+             const std::vector<int> &negative, Capacity capacity) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int x : keys) {
+        table.insert({x, x});
+    }
+    auto middle = std::chrono::high_resolution_clock::now();
+    size_t found_positive = 0, found_negative = 0;
+    for (int x : positive) {
+        found_positive += table.find(x) != nullptr;
+    }
+    auto positive_end = std::chrono::high_resolution_clock::now();
+    for (int x : negative) {
+        found_negative += table.find(x) != nullptr;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double> insert_time = middle - start, positive_time = positive_end - middle,
+                                  negative_time = end - positive_end;
+    std::cout << name << " (load " << double(keys.size()) / capacity() << "): insert " << keys.size() / insert_time.count() / 1e6
+              << " M/s, positive find " << positive.size() / positive_time.count() / 1e6 << " M/s, negative find "
+              << negative.size() / negative_time.count() / 1e6 << " M/s, "
+              << (found_positive == positive.size() && found_negative == 0 ? "PASS" : "FAIL") << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "--- cuckoo_Hash_Table Tests ---" << std::endl;
+    cuckoo_Hash_Table<int, std::string> s(16);
+    s.insert({10, "Ten"});
+    s.insert({18, "Eighteen"});
+    s.insert({26, "Twenty-six"});
+    s.remove(18);
+    auto result = s.find(26);
+    std::cout << "find(26): " << (result ? result->other : "not found") << ", find(18): "
+              << (s.find(18) ? "found" : "not found") << " (Expected: Twenty-six, not found)" << std::endl;
+
+    // random operations against std::unordered_map, growing from 16 slots
+    std::mt19937 gen(2025);
+    cuckoo_Hash_Table<int, int> checked(16);
+    std::unordered_map<int, int> expected;
+    bool pass = true;
+    for (int i = 0; i < 1000000 && pass; ++i) {
+        int key = gen() % 20000, op = gen() % 3;
+        if (op == 0) {
+            checked.insert({key, i});
+            expected.emplace(key, i);
+        } else if (op == 1) {
+            checked.remove(key);
+            expected.erase(key);
+        } else {
+            auto it = expected.find(key);
+            set<int, int> *x = checked.find(key);
+            pass = (it == expected.end()) ? x == nullptr : (x != nullptr && x->other == it->second);
+        }
+        pass = pass && checked.size() == expected.size();
+    }
+    std::cout << "Random operations: " << (pass ? "PASS" : "FAIL") << ", " << checked.size() << " elements in "
+              << checked.capacity() << " slots" << std::endl;
+
+    // 2 * SLOTS = 16 keys with the same key(x) fill both of their buckets, the 17th can not fit at any size
+    cuckoo_Hash_Table<int, int> colliding(16, [](const int &) { return 1597; });
+    int inserted = 0;
+    try {
+        for (; inserted < 17; ++inserted) {
+            colliding.insert({inserted, inserted});
+        }
+    } catch (const std::runtime_error &e) {
+        std::cout << "Colliding keys: " << e.what() << " at key " << inserted;
+    }
+    pass = inserted == 16 && colliding.size() == 16 && colliding.capacity() == 16;
+    for (int i = 0; i < inserted; ++i) {
+        pass = pass && colliding.find(i) != nullptr;
+    }
+    std::cout << ", " << colliding.size() << " elements in " << colliding.capacity() << " slots, all found: "
+              << (pass ? "PASS" : "FAIL") << std::endl;
+
+    // usage: cuckoo_Hash_Table [log2 of the slots] [load]
+    int bits = argc > 1 ? std::stoi(argv[1]) : 24;
+    double load = argc > 2 ? std::stod(argv[2]) : 0.95;
+    size_t slots = size_t(1) << bits, n = size_t(slots * load), query_num = 10000000;
+
+    std::cout << "\n--- Benchmark: " << n << " keys in " << slots << " slots, " << query_num << " lookups ---"
+              << std::endl;
+    std::vector<int> keys(n), positive(query_num), negative(query_num);
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = hit(uint32_t(i));
+    }
+    std::shuffle(keys.begin(), keys.end(), gen);
+    for (size_t i = 0; i < query_num; ++i) {
+        positive[i] = keys[gen() % n];
+        negative[i] = hit(uint32_t(n + gen() % (UINT32_MAX - n)));
+    }
+    {
+        // it doubles only if the breadth first search finds no free slot at this load
+        cuckoo_Hash_Table<int, int> table{int(slots)};
+        measure("cuckoo_Hash_Table", table, keys, positive, negative, [&]() { return table.capacity(); });
+    }
+    {
+        close_Hash_Table<int, int> table{int(slots), [](const int &x) { return x; }, 0.99};
+        measure("close_Hash_Table (Robin Hood)", table, keys, positive, negative, [&]() { return table.capacity(); });
+    }
+    {
+        open_Hash_Table<int, int> table(slots);
+        measure("open_Hash_Table (chaining)", table, keys, positive, negative, [&]() { return slots; });
+    }
+    return 0;
+}
+#endif
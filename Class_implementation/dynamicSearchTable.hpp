@@ -0,0 +1,26 @@
+#ifndef DYNAMIC_SEARCH_TABLE_HPP
+#define DYNAMIC_SEARCH_TABLE_HPP
+
+template<class KEY, class OTHER>
+struct set {
+    KEY key;
+    OTHER other;
+};
+
+// Dynamic Search Table
+template<class Key, class Other>
+class dynamicSearchTable {
+public:
+    // finding elements of x
+    virtual set<Key, Other> *find(const Key &x) const = 0;
+
+    // insert element, maintaining the order
+    virtual void insert(const set<Key, Other> &x) = 0;
+
+    // remove an element, maintaining the order
+    virtual void remove(const Key &x) = 0;
+
+    virtual ~dynamicSearchTable() {}
+};
+
+#endif//DYNAMIC_SEARCH_TABLE_HPP
@@ -0,0 +1,136 @@
+#ifndef EPOCH_DOMAIN_HPP
+#define EPOCH_DOMAIN_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Epoch-based reclamation (Fraser, 2004), shared by all concurrent containers.
+ * A thread announces the global epoch when it starts an operation. A retired node is freed
+ * once the global epoch is two steps ahead of its retirement, since by then every thread
+ * which could still see it has finished its operation. The epoch only advances when every
+ * active thread has announced the current one.
+ */
+class epochDomain {
+private:
+    struct retiredNode {
+        void *node;
+        void (*deleter)(void *);
+        uint64_t epoch;
+    };
+
+    struct threadRecord {
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<bool> active{false};
+        std::atomic<bool> in_use{true};
+        threadRecord *next = nullptr;
+        int depth = 0;// nested guards
+        std::vector<retiredNode> retired;
+    };
+
+    // releases the record of a thread when it exits, the next new thread adopts it
+    struct recordOwner {
+        threadRecord *record = nullptr;
+        ~recordOwner() {
+            if (record != nullptr) record->in_use.store(false, std::memory_order_release);
+        }
+    };
+
+    static const size_t COLLECT_GAP = 64;// try to advance the epoch every 64 retirements
+
+    static inline std::atomic<uint64_t> global_epoch{0};
+    static inline std::atomic<threadRecord *> records{nullptr};
+
+    static threadRecord *local() {
+        thread_local recordOwner owner;
+        if (owner.record != nullptr) {
+            return owner.record;
+        }
+        // adopt a record left by a finished thread, or push a new one; records are never freed
+        for (threadRecord *r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            bool expected = false;
+            if (!r->in_use.load(std::memory_order_relaxed) && r->in_use.compare_exchange_strong(expected, true)) {
+                owner.record = r;
+                return r;
+            }
+        }
+        threadRecord *r = new threadRecord;
+        r->next = records.load(std::memory_order_relaxed);
+        while (!records.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        owner.record = r;
+        return r;
+    }
+
+    static bool tryAdvance() {
+        uint64_t current = global_epoch.load(std::memory_order_seq_cst);
+        for (threadRecord *r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            if (r->active.load(std::memory_order_seq_cst) && r->epoch.load(std::memory_order_seq_cst) != current) {
+                return false;
+            }
+        }
+        return global_epoch.compare_exchange_strong(current, current + 1);
+    }
+
+    static void collect(threadRecord *r) {
+        tryAdvance();
+        uint64_t safe = global_epoch.load(std::memory_order_seq_cst);
+        size_t kept = 0;
+        for (size_t i = 0; i < r->retired.size(); ++i) {
+            if (r->retired[i].epoch + 2 <= safe) {
+                r->retired[i].deleter(r->retired[i].node);
+            } else {
+                r->retired[kept++] = r->retired[i];
+            }
+        }
+        r->retired.resize(kept);
+    }
+
+public:
+    static void enter() {
+        threadRecord *r = local();
+        if (r->depth++ == 0) {
+            r->active.store(true, std::memory_order_seq_cst);
+            r->epoch.store(global_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        }
+    }
+
+    static void exit() {
+        threadRecord *r = local();
+        if (--r->depth == 0) {
+            r->active.store(false, std::memory_order_release);
+        }
+    }
+
+    /**
+     * @brief free node with deleter once no thread can hold a reference to it any more,
+     * called after the node has been unlinked
+     */
+    static void retire(void *node, void (*deleter)(void *)) {
+        threadRecord *r = local();
+        r->retired.push_back(retiredNode{node, deleter, global_epoch.load(std::memory_order_seq_cst)});
+        if (r->retired.size() % COLLECT_GAP == 0) {
+            collect(r);
+        }
+    }
+};
+
+/**
+ * @brief RAII guard of an epoch, the nodes (and iterators) reached inside stay valid until it ends
+ */
+class epochGuard {
+public:
+    epochGuard() {
+        epochDomain::enter();
+    }
+
+    ~epochGuard() {
+        epochDomain::exit();
+    }
+
+    epochGuard(const epochGuard &) = delete;
+    epochGuard &operator=(const epochGuard &) = delete;
+};
+
+#endif//EPOCH_DOMAIN_HPP
@@ -6,6 +6,8 @@
 #include <iostream>
 #include <random>   // For std::random_device, std::mt19937, std::uniform_int_distribution
 #include <stdexcept>// For std::underflow_error
+#include <thread>   // For std::thread
+#include <vector>   // For std::vector
 
 // --- Priority Queue Class Definition ---
 
@@ -280,6 +282,127 @@ void heapSort(T *&arr, size_t size) {
     arr = sorted_arr;
 }
 
+// --- Bounded Top-K Accumulator (using the custom PriorityQueue) ---
+
+/**
+ * @brief Keeps the k largest elements of a stream in a size-k min-heap.
+ * The root is the smallest element kept, so an element which is not larger than
+ * the root is rejected with a single comparison, without touching the heap.
+ * Otherwise it replaces the root and is percolated down.
+ * Time Complexity: O(N) for a random stream (most elements are rejected), O(N log k) worst case.
+ * Space Complexity: O(k).
+ * @tparam T The type of elements. Must support comparison operators (<).
+ */
+template<typename T>
+class TopK {
+private:
+    size_t k;
+    PriorityQueue<T> heap;
+
+public:
+    explicit TopK(size_t k_) : k(k_), heap(k_) {}
+
+    size_t size() const {
+        return heap.current_size;
+    }
+
+    /**
+     * @brief Offers one element to the accumulator.
+     * @param x The element.
+     */
+    void push(const T &x) {
+        if (heap.current_size < k) {
+            heap.enQueue(x);
+        } else if (k > 0 && heap.array[1] < x) {
+            // replace the smallest kept element
+            heap.array[1] = x;
+            heap.percolateDown(1);
+        }
+    }
+
+    /**
+     * @brief Batched ingestion from an array, the root is kept in a local variable
+     * so that the reject path is one comparison against a register.
+     * @param data Pointer to the array of elements.
+     * @param size The number of elements in the `data` array.
+     */
+    void push(const T *data, size_t size) {
+        size_t i = 0;
+        for (; i < size && heap.current_size < k; ++i) {
+            heap.enQueue(data[i]);
+        }
+        if (k == 0 || i == size) {
+            return;
+        }
+
+        T threshold = heap.array[1];
+        for (; i < size; ++i) {
+            if (threshold < data[i]) {
+                heap.array[1] = data[i];
+                heap.percolateDown(1);
+                threshold = heap.array[1];
+            }
+        }
+    }
+
+    /**
+     * @brief Merges a partial result (e.g. from another thread) into this one.
+     * @param other Another accumulator, its k may differ.
+     */
+    void merge(const TopK &other) {
+        push(other.heap.array + 1, other.heap.current_size);
+    }
+
+    /**
+     * @brief Returns the kept elements in descending order.
+     */
+    std::vector<T> result() const {
+        PriorityQueue<T> tmp(heap);
+        std::vector<T> ans(tmp.current_size);
+        for (size_t i = ans.size(); i > 0; --i) {
+            ans[i - 1] = tmp.deQueue();
+        }
+        return ans;
+    }
+};
+
+/**
+ * @brief Parallel top-k: every thread accumulates one slice of the array, then the
+ * partial results are merged.
+ * @tparam T The type of elements.
+ * @param data Pointer to the array of elements.
+ * @param size The number of elements in the `data` array.
+ * @param k The number of largest elements to keep.
+ * @param thread_num 0 for std::thread::hardware_concurrency().
+ * @return The k largest elements in descending order.
+ */
+template<typename T>
+std::vector<T> parallelTopK(const T *data, size_t size, size_t k, size_t thread_num = 0) {
+    if (thread_num == 0) {
+        thread_num = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    std::vector<TopK<T>> partial(thread_num, TopK<T>(k));
+    std::vector<std::thread> pool;
+    size_t slice = (size + thread_num - 1) / thread_num;
+    for (size_t t = 0; t < thread_num; ++t) {
+        size_t begin = std::min(size, t * slice);
+        size_t end = std::min(size, begin + slice);
+        pool.emplace_back([&partial, data, t, begin, end]() {
+            partial[t].push(data + begin, end - begin);
+        });
+    }
+    for (auto &thread : pool) {
+        thread.join();
+    }
+
+    for (size_t t = 1; t < thread_num; ++t) {
+        partial[0].merge(partial[t]);
+    }
+    return partial[0].result();
+}
+
+#ifndef BENCHMARK_NO_MAIN
 // --- Test Utilities ---
 
 /**
@@ -508,5 +631,53 @@ int main() {
     std::cout << "Moved PQ (after move - should be empty/null): ";
     moved_pq.print_heap_array();// Should be empty/invalid state
 
+
+    // Test Case 8: Streaming Top-K against full Heap Sort
+    std::cout << "\n--- Test Case 8: Top-K Accumulator vs Heap Sort ---" << std::endl;
+    const size_t stream_size = 10000000;
+    const size_t k = 100;
+    int *stream = new int[stream_size];
+    for (size_t i = 0; i < stream_size; ++i) {
+        stream[i] = generate_random_int();
+    }
+
+    int *to_sort = new int[stream_size];
+    std::copy(stream, stream + stream_size, to_sort);
+    auto sort_start = std::chrono::high_resolution_clock::now();
+    heapSort(to_sort, stream_size);
+    auto sort_end = std::chrono::high_resolution_clock::now();
+    std::vector<int> expected(to_sort + stream_size - k, to_sort + stream_size);
+    std::reverse(expected.begin(), expected.end());
+    delete[] to_sort;
+
+    auto single_start = std::chrono::high_resolution_clock::now();
+    TopK<int> top(k);
+    for (size_t i = 0; i < stream_size; ++i) {
+        top.push(stream[i]);
+    }
+    std::vector<int> single = top.result();
+    auto batch_start = std::chrono::high_resolution_clock::now();
+    TopK<int> batch_top(k);
+    batch_top.push(stream, stream_size);
+    std::vector<int> batch = batch_top.result();
+    auto parallel_start = std::chrono::high_resolution_clock::now();
+    std::vector<int> parallel = parallelTopK(stream, stream_size, k);
+    auto parallel_end = std::chrono::high_resolution_clock::now();
+    delete[] stream;
+
+    std::chrono::duration<double> sort_time = sort_end - sort_start;
+    std::chrono::duration<double> single_time = batch_start - single_start;
+    std::chrono::duration<double> batch_time = parallel_start - batch_start;
+    std::chrono::duration<double> parallel_time = parallel_end - parallel_start;
+    std::cout << "Top " << k << " of " << stream_size << " elements" << std::endl;
+    std::cout << "Full heapSort:       " << sort_time.count() * 1000 << " ms" << std::endl;
+    std::cout << "TopK push one by one: " << single_time.count() * 1000 << " ms, "
+              << (single == expected ? "PASS" : "FAIL") << std::endl;
+    std::cout << "TopK batched push:    " << batch_time.count() * 1000 << " ms, "
+              << (batch == expected ? "PASS" : "FAIL") << std::endl;
+    std::cout << "parallelTopK (" << std::max<size_t>(1, std::thread::hardware_concurrency()) << " threads): "
+              << parallel_time.count() * 1000 << " ms, " << (parallel == expected ? "PASS" : "FAIL") << std::endl;
+
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -11,6 +11,7 @@
  #include <iterator>
  
  #include "Exceptions.hpp"
+ #include "batchLookup.hpp"
  #include "utility.hpp"
  
  namespace sjtu {
@@ -118,6 +119,41 @@
              array = new_array;
          }
  
+         /**
+          * @brief nodes[i] = the node of keys[i] for i in [0, count), nullptr if it does not exist, count <= FIND_BATCH.
+          * The lookups go through each stage together: hash and prefetch the buckets,
+          * prefetch the first nodes of the buckets, prefetch their data, then walk the buckets.
+          *
+          * @param keys
+          * @param count
+          * @param nodes
+          */
+         void find_group(const Key *keys, size_t count, Node **nodes) const {
+             size_t position[FIND_BATCH];
+             for (size_t i = 0; i < count; i++) {
+                 position[i] = hasher(keys[i]) % bucket_count;
+                 __builtin_prefetch(array + position[i]);
+             }
+             for (size_t i = 0; i < count; i++) {
+                 nodes[i] = array[position[i]].next_in_bucket;
+                 if (nodes[i] != nullptr) {
+                     __builtin_prefetch(nodes[i]);
+                 }
+             }
+             for (size_t i = 0; i < count; i++) {
+                 if (nodes[i] != nullptr) {
+                     __builtin_prefetch(nodes[i]->data);
+                 }
+             }
+             for (size_t i = 0; i < count; i++) {
+                 Node *it = nodes[i];
+                 while (it != nullptr && !key_equal(it->data->first, keys[i])) {
+                     it = it->next_in_bucket;
+                 }
+                 nodes[i] = it;
+             }
+         }
+
      public:
          /**
       * see BidirectionalIterator at CppReference for help.
@@ -167,6 +203,8 @@
              iterator(const iterator &other) {
                  pos = other.pos;
              }
+
+             iterator &operator=(const iterator &other) = default;
  
              /**
               * @brief Construct a new iterator object (when given a node pointer)
@@ -307,6 +345,8 @@
              const_iterator(const const_iterator &other) {
                  pos = other.pos;
              }
+
+             const_iterator &operator=(const const_iterator &other) = default;
  
              /**
               * @brief Construct a new const_iterator object (when given a node pointer)
@@ -823,6 +863,43 @@
              }
              return cend();
          }
+
+         /**
+          * @brief results[i] = find(keys[i]) for i in [0, n), with FIND_BATCH lookups interleaved at a time.
+          * Much faster than n calls of find when the table does not fit in the cache.
+          *
+          * @param keys
+          * @param n
+          * @param results
+          */
+         void find_batch(const Key *keys, size_t n, iterator *results) {
+             Node *nodes[FIND_BATCH];
+             for (size_t begin = 0; begin < n; begin += FIND_BATCH) {
+                 size_t count = n - begin < FIND_BATCH ? n - begin : FIND_BATCH;
+                 find_group(keys + begin, count, nodes);
+                 for (size_t i = 0; i < count; i++) {
+                     results[begin + i] = iterator(nodes[i] != nullptr ? nodes[i] : tail);
+                 }
+             }
+         }
+
+         /**
+          * @brief the const version of find_batch
+          *
+          * @param keys
+          * @param n
+          * @param results
+          */
+         void find_batch(const Key *keys, size_t n, const_iterator *results) const {
+             Node *nodes[FIND_BATCH];
+             for (size_t begin = 0; begin < n; begin += FIND_BATCH) {
+                 size_t count = n - begin < FIND_BATCH ? n - begin : FIND_BATCH;
+                 find_group(keys + begin, count, nodes);
+                 for (size_t i = 0; i < count; i++) {
+                     results[begin + i] = const_iterator(nodes[i] != nullptr ? nodes[i] : tail);
+                 }
+             }
+         }
      };
  
  }// namespace sjtu
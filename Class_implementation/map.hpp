@@ -5,6 +5,7 @@
 #define SJTU_MAP_HPP
 // only for std::less<T>
 #include "Exceptions.hpp"
+#include "batchLookup.hpp"
 #include "utility.hpp"
 #include <cmath>
 #include <cstddef>
@@ -140,6 +141,54 @@ namespace sjtu {
             return cur;
         }
 
+        /**
+         * @brief nodes[i] = the node of keys[i] for i in [0, count), nullptr if it does not exist, count <= FIND_BATCH.
+         * The lookups walk down together, one level per round: every round first prefetches the data of
+         * the current nodes, then compares and prefetches the children.
+         *
+         * @param keys
+         * @param count
+         * @param nodes
+         */
+        void find_group(const Key *keys, size_t count, Node **nodes) const {
+            bool walking[FIND_BATCH];
+            size_t active = 0;
+            for (size_t i = 0; i < count; ++i) {
+                nodes[i] = root;
+                walking[i] = root != nullptr;
+                active += walking[i];
+            }
+            while (active > 0) {
+                for (size_t i = 0; i < count; ++i) {
+                    if (walking[i]) {
+                        __builtin_prefetch(nodes[i]->data);
+                    }
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    if (!walking[i]) {
+                        continue;
+                    }
+                    Node *cur = nodes[i];
+                    if (Compare()(keys[i], cur->data->first)) {
+                        cur = cur->left;
+                    } else if (Compare()(cur->data->first, keys[i])) {
+                        cur = cur->right;
+                    } else {
+                        walking[i] = false;// found
+                        --active;
+                        continue;
+                    }
+                    nodes[i] = cur;
+                    if (cur == nullptr) {
+                        walking[i] = false;
+                        --active;
+                    } else {
+                        __builtin_prefetch(cur);
+                    }
+                }
+            }
+        }
+
         size_t height(Node *t) const {
             if (t == nullptr) {
                 return 0;
@@ -463,6 +512,7 @@ namespace sjtu {
              * @param other
              */
             iterator(const iterator &other) : pos(other.pos), which_map(other.which_map) {}
+            iterator &operator=(const iterator &other) = default;
 
             /**
              * @brief iter++ operation (traversal order)
@@ -563,6 +613,7 @@ namespace sjtu {
         public:
             const_iterator(const Node *pos_ = nullptr, const map *which_map_ = nullptr) : pos(pos_), which_map(which_map_) {}
             const_iterator(const const_iterator &other) : pos(other.pos), which_map(other.which_map) {}
+            const_iterator &operator=(const const_iterator &other) = default;
             const_iterator(const iterator &other) : pos(other.pos), which_map(other.which_map) {}
 
             /**
@@ -860,6 +911,15 @@ namespace sjtu {
             remove_node(pos->first, root);
         }
 
+        /**
+         * @brief the height of the AVL tree, 0 for an empty map
+         *
+         * @return size_t
+         */
+        size_t height() const {
+            return height(root);
+        }
+
         /**
          * @brief Returns the number of elements with key that compares equivalent to the specified argument
          *
@@ -900,6 +960,43 @@ namespace sjtu {
                 return const_iterator(current, this);
             }
         }
+
+        /**
+         * @brief results[i] = find(keys[i]) for i in [0, n), with FIND_BATCH lookups interleaved at a time.
+         * Much faster than n calls of find when the tree does not fit in the cache.
+         *
+         * @param keys
+         * @param n
+         * @param results
+         */
+        void find_batch(const Key *keys, size_t n, iterator *results) {
+            Node *nodes[FIND_BATCH];
+            for (size_t begin = 0; begin < n; begin += FIND_BATCH) {
+                size_t count = n - begin < FIND_BATCH ? n - begin : FIND_BATCH;
+                find_group(keys + begin, count, nodes);
+                for (size_t i = 0; i < count; ++i) {
+                    results[begin + i] = iterator(nodes[i] != nullptr ? nodes[i] : tail, this);
+                }
+            }
+        }
+
+        /**
+         * @brief the const version of find_batch
+         *
+         * @param keys
+         * @param n
+         * @param results
+         */
+        void find_batch(const Key *keys, size_t n, const_iterator *results) const {
+            Node *nodes[FIND_BATCH];
+            for (size_t begin = 0; begin < n; begin += FIND_BATCH) {
+                size_t count = n - begin < FIND_BATCH ? n - begin : FIND_BATCH;
+                find_group(keys + begin, count, nodes);
+                for (size_t i = 0; i < count; ++i) {
+                    results[begin + i] = const_iterator(nodes[i] != nullptr ? nodes[i] : tail, this);
+                }
+            }
+        }
     };
 }// namespace sjtu
 #endif
@@ -1,33 +1,260 @@
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <functional>
 #include <iostream>
+#include <new>
 #include <queue>
 #include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "batchLookup.hpp"
+#include "dynamicSearchTable.hpp"
 
-template<class KEY, class OTHER>
-struct set {
-    KEY key;
-    OTHER other;
-};
+/*
+Separate chaining: every bucket is a linked list of the elements hashed to it. The nodes come from a
+slab pool instead of one new per node, and the number of buckets doubles when the average chain
+length would exceed max_chain.
+*/
+template<class Key, class Other, class Hash = std::hash<Key>>
+class open_Hash_Table {
+private:
+    struct Node {
+        set<Key, Other> data;
+        Node *next;
+        size_t hash;// hasher(data.key), so a resize does not hash again and most mismatches skip the key comparison
+        Node(const set<Key, Other> &d, Node *n, size_t h) : data(d), next(n), hash(h) {}
+    };
+
+    /*
+    The nodes are carved out of slabs, each twice as large as the previous one up to MAX_SLAB nodes,
+    and removed nodes are kept in a free list for the next insertions. It saves the malloc header and
+    call of every node, and keeps the nodes inserted together close in memory.
+    */
+    class NodePool {
+    private:
+        static const size_t MIN_SLAB = 16;
+        static const size_t MAX_SLAB = 4096;
+
+        // a free node, its storage holds the next free one
+        struct FreeNode {
+            FreeNode *next;
+        };
+
+        std::vector<void *> slabs;
+        FreeNode *free_list;
+        char *current;// the unused part of the last slab
+        size_t remaining;
+
+    public:
+        NodePool() : free_list(nullptr), current(nullptr), remaining(0) {}
+
+        ~NodePool() {
+            for (void *slab : slabs) {
+                ::operator delete(slab);
+            }
+        }
+
+        NodePool(const NodePool &) = delete;
+        NodePool &operator=(const NodePool &) = delete;
+
+        Node *create(const set<Key, Other> &d, Node *n, size_t h) {
+            void *memory;
+            if (free_list != nullptr) {
+                memory = free_list;
+                free_list = free_list->next;
+            } else {
+                if (remaining == 0) {
+                    remaining = std::min(MAX_SLAB, MIN_SLAB << std::min<size_t>(slabs.size(), 8));
+                    current = static_cast<char *>(::operator new(remaining * sizeof(Node)));
+                    slabs.push_back(current);
+                }
+                memory = current;
+                current += sizeof(Node);
+                --remaining;
+            }
+            return new (memory) Node(d, n, h);
+        }
+
+        void destroy(Node *p) {
+            p->~Node();
+            FreeNode *node = reinterpret_cast<FreeNode *>(p);
+            node->next = free_list;
+            free_list = node;
+        }
+    };
+
+    // like the chunking algorithms
+    Node **array;
+    size_t size;
+    size_t element_count;
+    double max_chain;
+    Hash hasher;
+    NodePool pool;
+
+
+    /**
+     * @brief Move every node into a new array of count buckets, the nodes themselves stay in place
+     */
+    void rehash(size_t count) {
+        Node **new_array = new Node *[count]();
+        for (size_t i = 0; i < size; i++) {
+            Node *p = array[i];
+            while (p != nullptr) {
+                Node *q = p->next;
+                size_t pos = p->hash % count;
+                p->next = new_array[pos];
+                new_array[pos] = p;
+                p = q;
+            }
+        }
+        delete[] array;
+        array = new_array;
+        size = count;
+    }
 
-// Dynamic Search Table
-template<class Key, class Other>
-class dynamicSearchTable {
 public:
-    // finding elements of x
-    virtual set<Key, Other> *find(const Key &x) const = 0;
+    /**
+     * @brief Construct a new open_Hash_Table object
+     *
+     * @param size_ the initial number of buckets
+     * @param max_chain_ the buckets double when the average chain length would exceed it
+     * @param hasher_ the hash functor
+     */
+    open_Hash_Table(size_t size_ = 101, double max_chain_ = 1.0, const Hash &hasher_ = Hash())
+        : size(std::max<size_t>(size_, 1)), element_count(0), max_chain(max_chain_), hasher(hasher_) {
+        if (!(max_chain > 0)) {
+            throw std::invalid_argument("The max chain length should be positive!");
+        }
+        array = new Node *[size]();
+    }
+
+    ~open_Hash_Table() {
+        // the pool frees the memory, only the elements need to be destroyed
+        for (size_t i = 0; i < size; i++) {
+            Node *p = array[i];
+            while (p != nullptr) {
+                Node *q = p->next;
+                p->~Node();
+                p = q;
+            }
+        }
+        delete[] array;
+    }
+
+    open_Hash_Table(const open_Hash_Table &) = delete;
+    open_Hash_Table &operator=(const open_Hash_Table &) = delete;
+
+    set<Key, Other> *find(const Key &x) const {
+        size_t h = hasher(x);
+        Node *p = array[h % size];
+        while (p != nullptr && !(p->hash == h && p->data.key == x)) {
+            p = p->next;
+        }
+        // nullptr if we don't find the element
+        return p == nullptr ? nullptr : &p->data;
+    }
+
+    /**
+     * @brief results[i] = find(keys[i]) for i in [0, n).
+     * FIND_BATCH lookups go through each stage together: hash and prefetch the buckets,
+     * then load the chain heads and prefetch the first nodes, then walk the chains.
+     */
+    void find_batch(const Key *keys, size_t n, set<Key, Other> **results) const {
+        size_t h[FIND_BATCH];
+        Node *p[FIND_BATCH];
+        for (size_t begin = 0; begin < n; begin += FIND_BATCH) {
+            size_t count = std::min(FIND_BATCH, n - begin);
+            for (size_t i = 0; i < count; ++i) {
+                h[i] = hasher(keys[begin + i]);
+                __builtin_prefetch(array + h[i] % size);
+            }
+            for (size_t i = 0; i < count; ++i) {
+                p[i] = array[h[i] % size];
+                if (p[i] != nullptr) {
+                    __builtin_prefetch(p[i]);
+                }
+            }
+            for (size_t i = 0; i < count; ++i) {
+                Node *q = p[i];
+                while (q != nullptr && !(q->hash == h[i] && q->data.key == keys[begin + i])) {
+                    q = q->next;
+                }
+                results[begin + i] = q == nullptr ? nullptr : &q->data;
+            }
+        }
+    }
 
-    // insert element, maintaining the order
-    virtual void insert(const set<Key, Other> &x) = 0;
+    void insert(const set<Key, Other> &x) {
+        if (element_count + 1 > max_chain * size) {
+            rehash(size * 2);
+        }
+        size_t h = hasher(x.key), pos = h % size;
+        array[pos] = pool.create(x, array[pos], h);
+        ++element_count;
+    }
+
+    void remove(const Key &x) {
+        // p points at the link to the node being checked
+        size_t h = hasher(x);
+        Node **p = array + h % size;
+        while (*p != nullptr && !((*p)->hash == h && (*p)->data.key == x)) {
+            p = &(*p)->next;
+        }
+        if (*p != nullptr) {
+            // we find the element
+            Node *q = *p;
+            *p = q->next;
+            pool.destroy(q);
+            --element_count;
+        }
+    }
 
-    // remove an element, maintaining the order
-    virtual void remove(const Key &x) = 0;
+    /**
+     * @brief the number of elements
+     */
+    size_t elementCount() const {
+        return element_count;
+    }
 
-    virtual ~dynamicSearchTable() {}
+    /**
+     * @brief the number of buckets
+     */
+    size_t bucketCount() const {
+        return size;
+    }
 };
 
+// one generator per thread, seeded once: seeding a std::mt19937 for every number costs far more than the number
+std::mt19937 &random_engine() {
+    thread_local std::mt19937 gen(std::random_device{}());
+    return gen;
+}
+
+int generate_random(int range = 100000) {
+    std::uniform_int_distribution<> dis(1, range);
+    return dis(random_engine());
+}
+
+std::string generate_random_string(size_t length = 20) {
+    const std::string characters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    std::uniform_int_distribution<> dis(0, characters.size() - 1);
+
+    std::string random_string;
+    for (size_t i = 0; i < length; ++i) {
+        random_string += characters[dis(random_engine())];
+    }
+    return random_string;
+}
+
+#ifndef BENCHMARK_NO_MAIN
+// The previous open_Hash_Table: an int (*)(const Key &) hash function, one new per node and a fixed
+// number of buckets, kept as the baseline of the benchmark below
 template<class Key, class Other>
-class open_Hash_Table {
+class pointer_Hash_Table {
 private:
     struct Node {
         set<Key, Other> data;
@@ -47,7 +274,7 @@ private:
     }
 
 public:
-    open_Hash_Table(size_t size_, int (*f)(const Key &x) = defaultKey) {
+    pointer_Hash_Table(size_t size_, int (*f)(const Key &x) = defaultKey) {
         size = size_;
         key = f;
         array = new Node *[size];
@@ -58,7 +285,7 @@ public:
         }
     }
 
-    ~open_Hash_Table() {
+    ~pointer_Hash_Table() {
         // delete all the array
         Node *p, *q;
         for (int i = 0; i < size; i++) {
@@ -67,9 +294,10 @@ public:
             while (p != nullptr) {
                 q = p->next;
                 delete p;
-                p = p->next;
+                p = q;
             }
         }
+        delete[] array;
     }
 
     set<Key, Other> *find(const Key &x) const {
@@ -130,60 +358,99 @@ public:
     }
 };
 
-int generate_random(int range = 100000) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(1, range);
-    return dis(gen);
-}
-
-std::string generate_random_string(size_t length = 20) {
-    const std::string characters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, characters.size() - 1);
 
-    std::string random_string;
-    for (size_t i = 0; i < length; ++i) {
-        random_string += characters[dis(gen)];
-    }
-    return random_string;
+int stringKey(const std::string &x) {
+    return int(std::hash<std::string>()(x));
 }
 
-
-int main() {
-    open_Hash_Table<int, std::string> s(10000);
-    long long alldata_range = 1000000000;
-    long long alldata_num = 8000;
-    long long query_num = 1000000;
-    set<int, std::string> element;
-    std::queue<int> storage;
-
-    for (int i = 0; i < alldata_num; i++) {
-        set<int, std::string> element;
-        element.key = generate_random(alldata_range);
-        element.other = generate_random_string();
-        s.insert(element);
-        storage.push(element.key);
+/**
+ * @brief Time the inserts of keys, the finds of keys and of missing, and the removes of keys, in M/s
+ */
+template<class Table>
+void measure(const std::string &name, Table &table, const std::vector<std::string> &keys,
+             const std::vector<std::string> &missing) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        table.insert({keys[i], int(i)});
+    }
+    auto inserted = std::chrono::high_resolution_clock::now();
+    size_t found = 0;
+    for (const std::string &x : keys) {
+        found += table.find(x) != nullptr;
+    }
+    auto hit = std::chrono::high_resolution_clock::now();
+    for (const std::string &x : missing) {
+        found += table.find(x) != nullptr;
     }
+    auto miss = std::chrono::high_resolution_clock::now();
+    for (const std::string &x : keys) {
+        table.remove(x);
+    }
+    auto removed = std::chrono::high_resolution_clock::now();
 
-    // for the searching period
-    for (int i = 0; i < query_num; i++) {
-        int search_key = generate_random(alldata_range);
-        if (s.find(search_key) != nullptr) {
-            std::cout << "Find the key value " << search_key << std::endl;
-        }
+    std::chrono::duration<double> insert_time = inserted - start, hit_time = hit - inserted, miss_time = miss - hit,
+                                  remove_time = removed - miss;
+    std::cout << name << ": insert " << keys.size() / insert_time.count() / 1e6 << " M/s, find (hit) "
+              << keys.size() / hit_time.count() / 1e6 << " M/s, find (miss) " << missing.size() / miss_time.count() / 1e6
+              << " M/s, remove " << keys.size() / remove_time.count() / 1e6 << " M/s, "
+              << (found == keys.size() ? "PASS" : "FAIL") << std::endl;
+}
 
-        if (generate_random(1000) % 3 == 0 && !storage.empty()) {
-            // randomly remove some elements
-            int dele = storage.front();
-            s.remove(dele);
-            if (s.find(dele) == nullptr) {
-                std::cout << "The key value " << dele << " has been deleted successfully." << std::endl;
+int main(int argc, char *argv[]) {
+    std::cout << "--- open_Hash_Table Tests ---" << std::endl;
+    open_Hash_Table<std::string, int> s(4);
+    s.insert({"Ten", 10});
+    s.insert({"Eighteen", 18});
+    s.insert({"Twenty-six", 26});
+    s.remove("Eighteen");
+    auto result = s.find("Twenty-six");
+    std::cout << "find(Twenty-six): " << (result ? std::to_string(result->other) : "not found")
+              << ", find(Eighteen): " << (s.find("Eighteen") ? "found" : "not found")
+              << " (Expected: 26, not found)" << std::endl;
+
+    // random operations against std::unordered_map, growing from 1 bucket
+    open_Hash_Table<int, int> checked(1);
+    std::unordered_map<int, int> expected;
+    bool pass = true;
+    for (int i = 0; i < 1000000 && pass; ++i) {
+        int key = generate_random(20000), op = generate_random(3);
+        if (op == 1) {
+            if (expected.emplace(key, i).second) {
+                checked.insert({key, i});
             }
-            storage.pop();
+        } else if (op == 2) {
+            checked.remove(key);
+            expected.erase(key);
+        } else {
+            auto it = expected.find(key);
+            set<int, int> *x = checked.find(key);
+            pass = (it == expected.end()) ? x == nullptr : (x != nullptr && x->other == it->second);
         }
+        pass = pass && checked.elementCount() == expected.size();
     }
+    std::cout << "Random operations: " << (pass ? "PASS" : "FAIL") << ", " << checked.elementCount() << " elements in "
+              << checked.bucketCount() << " buckets" << std::endl;
 
+    // usage: open_Hash_Table [elements]
+    size_t n = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    std::cout << "\n--- Benchmark: " << n << " random strings of 20 characters ---" << std::endl;
+    std::vector<std::string> keys(n), missing(n);
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = generate_random_string();
+        missing[i] = generate_random_string(19);
+    }
+    {
+        pointer_Hash_Table<std::string, int> table(n, stringKey);
+        measure("previous table, " + std::to_string(n) + " buckets", table, keys, missing);
+    }
+    {
+        open_Hash_Table<std::string, int> table(n);
+        measure("open_Hash_Table, " + std::to_string(n) + " buckets", table, keys, missing);
+    }
+    {
+        open_Hash_Table<std::string, int> table;
+        measure("open_Hash_Table, growing from 101 buckets", table, keys, missing);
+    }
     return 0;
 }
+#endif
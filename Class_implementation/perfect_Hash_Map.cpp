@@ -0,0 +1,531 @@
+/*
+A static hash map for key sets which are built once and only read: a minimal perfect hash function
+in the style of PTHash (Pibiri and Trani, "PTHash: Revisiting FCH Minimal Perfect Hashing", 2021)
+sends the n keys to n distinct slots, so a lookup is one hash, one pilot and one record, with no probing.
+A built map can be saved as one flat binary image and used in place from a memory-mapped file.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "batchLookup.hpp"
+#include "dynamicSearchTable.hpp"
+
+/**
+ * @brief A read-only map of the keys given at construction.
+ *
+ * The keys are split into buckets, about LAMBDA keys each (60% of the keys in the first 30% of the
+ * buckets, which are placed first while the table is empty). Every bucket gets the first pilot which
+ * sends all of its keys to free slots of a table of n / ALPHA slots, and the slots past n are then
+ * remapped to the free slots below n, so the records fill exactly n slots.
+ */
+template<class Key, class Other, class Hash = std::hash<Key>>
+class perfect_Hash_Map {
+private:
+    static constexpr double LAMBDA = 3.5;// the average keys per bucket
+    static constexpr double ALPHA = 0.98;// the load of the table searched for the pilots
+    static const int MAX_SEEDS = 16;
+    static const uint32_t DENSE_KEYS = uint32_t(0.6 * 4294967296.0);
+    static const uint64_t MAGIC = 0x31504D4850485350ull;// "PSHPHMP1"
+
+    // the binary image: the header, then the pilots, the remapped slots and the records, each 64-byte aligned
+    struct header {
+        uint64_t magic;
+        uint64_t key_count;
+        uint64_t table_size;
+        uint64_t bucket_count;
+        uint64_t dense_buckets;
+        uint64_t seed;
+        uint64_t record_size;
+    };
+
+    header info;
+    const uint16_t *pilots;
+    const uint32_t *remap;// the slot below n of every slot from n to table_size - 1
+    const set<Key, Other> *records;
+    // the storage of a built map, empty for a map viewing an image
+    std::vector<uint16_t> pilot_storage;
+    std::vector<uint32_t> remap_storage;
+    std::vector<set<Key, Other>> record_storage;
+    Hash hasher;
+
+    static uint64_t mix(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    // a value in [0, range) from the high 32 bits of x, by multiply and shift instead of a modulo
+    static uint64_t reduce(uint64_t x, uint64_t range) {
+        return ((x >> 32) * range) >> 32;
+    }
+
+    static size_t aligned(size_t bytes) {
+        return (bytes + 63) / 64 * 64;
+    }
+
+    uint64_t hashOf(const Key &x) const {
+        return mix(uint64_t(hasher(x)) ^ info.seed);
+    }
+
+    uint64_t bucketOf(uint64_t h) const {
+        if (uint32_t(h) < DENSE_KEYS) {
+            return reduce(h, info.dense_buckets);
+        }
+        return info.dense_buckets + reduce(h, info.bucket_count - info.dense_buckets);
+    }
+
+    // the slot of a key in the table of the pilot search, from a second hash of the key xor the hashed pilot
+    uint64_t slotOf(uint64_t h, uint64_t pilot_hash) const {
+        return reduce((h * 0x9E3779B97F4A7C15ull) ^ pilot_hash, info.table_size);
+    }
+
+    /**
+     * @brief Search the pilots with info.seed, false if a bucket needs a pilot above 65535 or two keys
+     * have the same hash, which another seed fixes
+     */
+    bool build(const std::vector<set<Key, Other>> &elements) {
+        size_t n = elements.size();
+        std::vector<uint64_t> hashes(n);
+        for (size_t i = 0; i < n; ++i) {
+            hashes[i] = hashOf(elements[i].key);
+        }
+        // the hashes of each bucket side by side, by a counting sort
+        std::vector<uint32_t> bucket_start(info.bucket_count + 1, 0);
+        std::vector<uint64_t> bucket_hashes(n);
+        for (size_t i = 0; i < n; ++i) {
+            ++bucket_start[bucketOf(hashes[i]) + 1];
+        }
+        for (size_t b = 0; b < info.bucket_count; ++b) {
+            bucket_start[b + 1] += bucket_start[b];
+        }
+        {
+            std::vector<uint32_t> next(bucket_start.begin(), bucket_start.end() - 1);
+            for (size_t i = 0; i < n; ++i) {
+                bucket_hashes[next[bucketOf(hashes[i])]++] = hashes[i];
+            }
+        }
+        // the largest buckets first, while most slots are free
+        std::vector<uint32_t> buckets(info.bucket_count);
+        for (size_t b = 0; b < info.bucket_count; ++b) {
+            buckets[b] = uint32_t(b);
+        }
+        std::stable_sort(buckets.begin(), buckets.end(), [&](uint32_t a, uint32_t b) {
+            return bucket_start[a + 1] - bucket_start[a] > bucket_start[b + 1] - bucket_start[b];
+        });
+
+        pilot_storage.assign(info.bucket_count, 0);
+        std::vector<uint64_t> taken((info.table_size + 63) / 64, 0);
+        std::vector<uint64_t> slots;
+        for (uint32_t b : buckets) {
+            uint32_t begin = bucket_start[b], end = bucket_start[b + 1];
+            if (begin == end) {
+                break;
+            }
+            for (uint32_t pilot = 0;; ++pilot) {
+                if (pilot > UINT16_MAX) {
+                    return false;
+                }
+                slots.clear();
+                bool fits = true;
+                uint64_t pilot_hash = mix(pilot);
+                for (uint32_t i = begin; i < end && fits; ++i) {
+                    uint64_t slot = slotOf(bucket_hashes[i], pilot_hash);
+                    fits = !(taken[slot / 64] >> (slot % 64) & 1) &&
+                           std::find(slots.begin(), slots.end(), slot) == slots.end();
+                    slots.push_back(slot);
+                }
+                if (fits) {
+                    for (uint64_t slot : slots) {
+                        taken[slot / 64] |= 1ull << (slot % 64);
+                    }
+                    pilot_storage[b] = uint16_t(pilot);
+                    break;
+                }
+                // two keys of the bucket with the same hash never fit
+                if (end - begin > 1 && pilot == 0) {
+                    std::vector<uint64_t> same(bucket_hashes.begin() + begin, bucket_hashes.begin() + end);
+                    std::sort(same.begin(), same.end());
+                    if (std::adjacent_find(same.begin(), same.end()) != same.end()) {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        // the slots past n go to the free slots below n, in order
+        remap_storage.assign(info.table_size - n, 0);
+        uint64_t free_slot = 0;
+        for (uint64_t slot = n; slot < info.table_size; ++slot) {
+            if (taken[slot / 64] >> (slot % 64) & 1) {
+                while (taken[free_slot / 64] >> (free_slot % 64) & 1) {
+                    ++free_slot;
+                }
+                remap_storage[slot - n] = uint32_t(free_slot++);
+            }
+        }
+        pilots = pilot_storage.data();
+        remap = remap_storage.data();
+        record_storage.assign(n, set<Key, Other>());
+        for (size_t i = 0; i < n; ++i) {
+            record_storage[slot(hashes[i])] = elements[i];
+        }
+        records = record_storage.data();
+        return true;
+    }
+
+    uint64_t slot(uint64_t h) const {
+        uint64_t s = slotOf(h, mix(pilots[bucketOf(h)]));
+        return s < info.key_count ? s : remap[s - info.key_count];
+    }
+
+    perfect_Hash_Map() : info(), pilots(nullptr), remap(nullptr), records(nullptr) {}
+
+public:
+    /**
+     * @brief Build the map of elements, whose keys must be distinct
+     *
+     * @throw std::invalid_argument on a repeated key
+     */
+    explicit perfect_Hash_Map(const std::vector<set<Key, Other>> &elements, const Hash &hasher_ = Hash())
+        : info(), pilots(nullptr), remap(nullptr), records(nullptr), hasher(hasher_) {
+        size_t n = elements.size();
+        if (n >= UINT32_MAX) {
+            throw std::length_error("Too many keys for a perfect_Hash_Map!");
+        }
+        info.magic = MAGIC;
+        info.key_count = n;
+        info.table_size = std::max<uint64_t>(n, uint64_t(n / ALPHA));
+        info.bucket_count = std::max<uint64_t>(2, uint64_t(n / LAMBDA));
+        info.dense_buckets = std::max<uint64_t>(1, uint64_t(info.bucket_count * 0.3));
+        info.record_size = sizeof(set<Key, Other>);
+        for (int attempt = 0; attempt < MAX_SEEDS; ++attempt) {
+            info.seed = mix(attempt + 1);
+            if (build(elements)) {
+                return;
+            }
+        }
+        // the seeds only fail on equal hashes, which are equal keys unless the hash is very poor
+        throw std::invalid_argument("The keys of a perfect_Hash_Map should be distinct!");
+    }
+
+    perfect_Hash_Map(perfect_Hash_Map &&) = default;
+    perfect_Hash_Map(const perfect_Hash_Map &) = delete;
+    perfect_Hash_Map &operator=(const perfect_Hash_Map &) = delete;
+
+    /**
+     * @brief the record of x, nullptr if x is not a key of the map
+     */
+    const set<Key, Other> *find(const Key &x) const {
+        if (info.key_count == 0) {
+            return nullptr;
+        }
+        const set<Key, Other> *record = records + slot(hashOf(x));
+        return record->key == x ? record : nullptr;
+    }
+
+    /**
+     * @brief results[i] = find(keys[i]) for i in [0, n).
+     * The pilots of FIND_BATCH keys are prefetched, then their records, so that the two cache misses of
+     * a lookup overlap with those of the others.
+     */
+    void find_batch(const Key *keys, size_t n, const set<Key, Other> **results) const {
+        uint64_t h[FIND_BATCH];
+        for (size_t begin = 0; begin < n && info.key_count != 0; begin += FIND_BATCH) {
+            size_t count = std::min(FIND_BATCH, n - begin);
+            for (size_t i = 0; i < count; ++i) {
+                h[i] = hashOf(keys[begin + i]);
+                __builtin_prefetch(pilots + bucketOf(h[i]));
+            }
+            for (size_t i = 0; i < count; ++i) {
+                h[i] = slot(h[i]);
+                __builtin_prefetch(records + h[i]);
+            }
+            for (size_t i = 0; i < count; ++i) {
+                const set<Key, Other> *record = records + h[i];
+                results[begin + i] = record->key == keys[begin + i] ? record : nullptr;
+            }
+        }
+        if (info.key_count == 0) {
+            std::fill(results, results + n, nullptr);
+        }
+    }
+
+    size_t size() const {
+        return info.key_count;
+    }
+
+    /**
+     * @brief the bytes of the hash function: the pilots and the remapped slots, without the records
+     */
+    size_t functionBytes() const {
+        return info.bucket_count * sizeof(uint16_t) + (info.table_size - info.key_count) * sizeof(uint32_t);
+    }
+
+    /**
+     * @brief Write the binary image of the map, which view uses in place. The records are copied
+     * byte for byte, so Key and Other must be trivially copyable, and Hash must give the same
+     * values in the reading program.
+     */
+    void save(std::ostream &out) const {
+        static_assert(std::is_trivially_copyable<set<Key, Other>>::value, "Only trivially copyable records can be saved");
+        static_assert(alignof(set<Key, Other>) <= 64, "The records of an image are 64-byte aligned");
+        const char padding[64] = {};
+        auto section = [&](const void *data, size_t bytes) {
+            out.write(static_cast<const char *>(data), std::streamsize(bytes));
+            out.write(padding, std::streamsize(aligned(bytes) - bytes));
+        };
+        section(&info, sizeof(header));
+        section(pilots, info.bucket_count * sizeof(uint16_t));
+        section(remap, (info.table_size - info.key_count) * sizeof(uint32_t));
+        section(records, info.key_count * sizeof(set<Key, Other>));
+    }
+
+    /**
+     * @brief A map reading the image at data (e.g. a memory-mapped file written by save), which must be
+     * 64-byte aligned and outlive the map
+     *
+     * @throw std::invalid_argument if data is not an image of this kind of map, or is shorter than the
+     * sections its header declares, or the header or the remapped slots point out of the image
+     */
+    static perfect_Hash_Map view(const void *data, size_t bytes, const Hash &hasher_ = Hash()) {
+        static_assert(std::is_trivially_copyable<set<Key, Other>>::value, "Only trivially copyable records can be viewed");
+        perfect_Hash_Map map;
+        map.hasher = hasher_;
+        const char *p = static_cast<const char *>(data);
+        if (p == nullptr || reinterpret_cast<uintptr_t>(p) % 64 != 0) {
+            throw std::invalid_argument("The image of a perfect_Hash_Map should be 64-byte aligned!");
+        }
+        if (bytes < sizeof(header)) {
+            throw std::invalid_argument("Not the image of a perfect_Hash_Map!");
+        }
+        std::memcpy(&map.info, p, sizeof(header));
+        const header &info = map.info;
+        // the same bounds as the constructor, so that bucketOf and slot stay inside the sections
+        if (info.magic != MAGIC || info.record_size != sizeof(set<Key, Other>) || info.key_count >= UINT32_MAX ||
+            info.table_size < info.key_count || info.bucket_count < 2 || info.dense_buckets == 0 ||
+            info.dense_buckets >= info.bucket_count) {
+            throw std::invalid_argument("Not the image of a perfect_Hash_Map!");
+        }
+        // every count is checked against bytes before it is multiplied, so a corrupt one can not wrap around
+        if (info.bucket_count > bytes / sizeof(uint16_t) || info.table_size - info.key_count > bytes / sizeof(uint32_t) ||
+            info.key_count > bytes / sizeof(set<Key, Other>) ||
+            aligned(sizeof(header)) + aligned(info.bucket_count * sizeof(uint16_t)) +
+                            aligned((info.table_size - info.key_count) * sizeof(uint32_t)) +
+                            aligned(info.key_count * sizeof(set<Key, Other>)) > bytes) {
+            throw std::invalid_argument("The image of a perfect_Hash_Map is truncated!");
+        }
+        p += aligned(sizeof(header));
+        map.pilots = reinterpret_cast<const uint16_t *>(p);
+        p += aligned(info.bucket_count * sizeof(uint16_t));
+        map.remap = reinterpret_cast<const uint32_t *>(p);
+        p += aligned((info.table_size - info.key_count) * sizeof(uint32_t));
+        map.records = reinterpret_cast<const set<Key, Other> *>(p);
+        // about 2% of the table, far less than the records
+        for (uint64_t i = 0; i < info.table_size - info.key_count; ++i) {
+            if (map.remap[i] >= info.key_count) {
+                throw std::invalid_argument("Not the image of a perfect_Hash_Map!");
+            }
+        }
+        return map;
+    }
+};
+
+#ifndef BENCHMARK_NO_MAIN
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define BENCHMARK_NO_MAIN
+#include "close_Hash_Table.cpp"
+#undef BENCHMARK_NO_MAIN
+
+double seconds(std::chrono::high_resolution_clock::time_point start) {
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count();
+}
+
+/**
+ * @brief Time the lookups of queries in M/s, found counts the keys found
+ */
+template<class Table>
+double lookupRate(const Table &table, const std::vector<int> &queries, size_t &found) {
+    found = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int x : queries) {
+        auto record = table.find(x);
+        found += record != nullptr && record->other == x;
+    }
+    return queries.size() / seconds(start) / 1e6;
+}
+
+/**
+ * @brief Time the lookups of queries by find_batch in M/s, found counts the keys found
+ */
+template<class Table, class Record>
+double batchRate(const Table &table, const std::vector<int> &queries, size_t &found) {
+    const size_t batch_size = 4096;
+    std::vector<Record *> results(batch_size);
+    found = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t begin = 0; begin < queries.size(); begin += batch_size) {
+        size_t count = std::min(batch_size, queries.size() - begin);
+        table.find_batch(queries.data() + begin, count, results.data());
+        for (size_t i = 0; i < count; ++i) {
+            found += results[i] != nullptr && results[i]->other == queries[begin + i];
+        }
+    }
+    return queries.size() / seconds(start) / 1e6;
+}
+
+/**
+ * @brief Build close_Hash_Table and perfect_Hash_Map of n random keys, compare them on half hits and
+ * half misses, then save the map, memory-map the file and compare again
+ */
+void compare(size_t n, size_t query_num) {
+    std::mt19937 gen(2025);
+    std::uniform_int_distribution<int> dis(0, INT32_MAX);
+    std::vector<int> keys(n);
+    for (int &key : keys) key = dis(gen);
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::shuffle(keys.begin(), keys.end(), gen);
+    n = keys.size();
+    std::vector<int> queries(query_num);
+    for (size_t i = 0; i < query_num; ++i) {
+        queries[i] = (i % 2 == 0) ? keys[gen() % n] : dis(gen);
+    }
+    std::vector<set<int, int>> elements(n);
+    for (size_t i = 0; i < n; ++i) {
+        elements[i] = {keys[i], keys[i]};
+    }
+    std::cout << "--- " << n << " keys, " << query_num << " lookups (half of them hits) ---" << std::endl;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    close_Hash_Table<int, int> table;
+    for (auto &x : elements) table.insert(x);
+    double table_build = seconds(start);
+    size_t expected, found;
+    double table_rate = lookupRate(table, queries, expected);
+    double table_batch = batchRate<close_Hash_Table<int, int>, set<int, int>>(table, queries, found);
+    std::cout << "close_Hash_Table: build " << table_build * 1000 << " ms, "
+              << table.capacity() * (sizeof(set<int, int>) + 1) * 8.0 / n << " bits per key, " << table_rate
+              << " M lookups/s, find_batch " << table_batch << " M/s" << std::endl;
+
+    start = std::chrono::high_resolution_clock::now();
+    perfect_Hash_Map<int, int> map(elements);
+    double map_build = seconds(start);
+    double map_rate = lookupRate(map, queries, found);
+    size_t batch_found;
+    double map_batch = batchRate<perfect_Hash_Map<int, int>, const set<int, int>>(map, queries, batch_found);
+    std::cout << "perfect_Hash_Map: build " << map_build * 1000 << " ms, " << map.functionBytes() * 8.0 / n
+              << " bits per key for the function, "
+              << (map.functionBytes() + n * sizeof(set<int, int>)) * 8.0 / n << " with the records, " << map_rate
+              << " M lookups/s, find_batch " << map_batch << " M/s, "
+              << (found == expected && batch_found == expected ? "PASS" : "FAIL") << std::endl;
+
+    std::string path = "perfect_Hash_Map.bin";
+    {
+        std::ofstream out(path, std::ios::binary);
+        map.save(out);
+        if (!out) {
+            throw std::runtime_error("Cannot write " + path);
+        }
+    }
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    start = std::chrono::high_resolution_clock::now();
+    void *image = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (image == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Cannot map " + path);
+    }
+    auto mapped = perfect_Hash_Map<int, int>::view(image, size_t(status.st_size));
+    double open_time = seconds(start);
+    double mapped_rate = lookupRate(mapped, queries, found);
+    std::cout << "memory-mapped image: " << status.st_size << " bytes, opened in " << open_time * 1000 << " ms, "
+              << mapped_rate << " M lookups/s, " << (found == expected ? "PASS" : "FAIL") << std::endl;
+    munmap(image, size_t(status.st_size));
+    close(fd);
+    std::remove(path.c_str());
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "--- perfect_Hash_Map Tests ---" << std::endl;
+    std::vector<set<std::string, int>> words = {{"one", 1}, {"two", 2}, {"three", 3}, {"four", 4}, {"five", 5}};
+    perfect_Hash_Map<std::string, int> s(words);
+    auto result = s.find("three");
+    std::cout << "find(three): " << (result ? result->other : -1) << ", find(six): "
+              << (s.find("six") ? "found" : "not found") << " (Expected: 3, not found)" << std::endl;
+    try {
+        perfect_Hash_Map<std::string, int> repeated({{"one", 1}, {"one", 2}});
+        std::cout << "Repeated keys: FAIL" << std::endl;
+    } catch (const std::invalid_argument &e) {
+        std::cout << "Repeated keys: PASS (" << e.what() << ")" << std::endl;
+    }
+    bool pass = true;
+    for (size_t n : {0, 1, 2, 3, 10, 100, 1000}) {
+        std::vector<set<int, int>> elements;
+        for (size_t i = 0; i < n; ++i) elements.push_back({int(i * 7919), int(i)});
+        perfect_Hash_Map<int, int> map(elements);
+        for (size_t i = 0; i < n; ++i) pass = pass && map.find(int(i * 7919)) && map.find(int(i * 7919))->other == int(i);
+        pass = pass && map.find(-1) == nullptr;
+    }
+    std::cout << "Small maps: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+    // truncated and corrupt images are refused instead of being read out of bounds
+    std::vector<set<int, int>> elements;
+    for (int i = 0; i < 1000; ++i) elements.push_back({i * 7919, i});
+    std::ostringstream saved;
+    perfect_Hash_Map<int, int>(elements).save(saved);
+    std::string bytes = saved.str();
+    std::vector<char> buffer(bytes.size() + 64);
+    char *image = buffer.data() + (64 - reinterpret_cast<uintptr_t>(buffer.data()) % 64) % 64;
+    // write value (of width bytes) at offset of a fresh copy of the image, true if view refuses it
+    auto refused = [&](size_t length, size_t offset, uint64_t value, size_t width) {
+        std::memcpy(image, bytes.data(), bytes.size());
+        std::memcpy(image + offset, &value, width);
+        try {
+            perfect_Hash_Map<int, int>::view(image, length);
+        } catch (const std::invalid_argument &) {
+            return true;
+        }
+        return false;
+    };
+    // the header is magic, key_count, table_size, bucket_count, dense_buckets, seed and record_size,
+    // the remapped slots follow the 64-byte aligned pilots
+    uint64_t bucket_count, magic;
+    std::memcpy(&magic, bytes.data(), sizeof(uint64_t));
+    std::memcpy(&bucket_count, bytes.data() + 3 * sizeof(uint64_t), sizeof(uint64_t));
+    size_t remap_offset = 64 + (bucket_count * sizeof(uint16_t) + 63) / 64 * 64;
+    pass = !refused(bytes.size(), 0, magic, sizeof(uint64_t)) && refused(bytes.size() - 64, 0, magic, sizeof(uint64_t)) &&
+           refused(40, 0, magic, sizeof(uint64_t)) && refused(bytes.size(), 3 * 8, uint64_t(1) << 62, sizeof(uint64_t)) &&
+           refused(bytes.size(), 4 * 8, 0, sizeof(uint64_t)) && refused(bytes.size(), 2 * 8, UINT64_MAX, sizeof(uint64_t)) &&
+           refused(bytes.size(), 1 * 8, 2000, sizeof(uint64_t)) && refused(bytes.size(), remap_offset, 1000, sizeof(uint32_t));
+    std::cout << "Truncated and corrupt images: " << (pass ? "PASS" : "FAIL") << std::endl << std::endl;
+
+    // usage: perfect_Hash_Map [keys] [lookups]
+    size_t n = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    size_t query_num = argc > 2 ? std::stoull(argv[2]) : 10000000;
+    compare(8000, 1000000);
+    compare(n, query_num);
+    return 0;
+}
+#endif
@@ -1,4 +1,11 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 template<typename Key, typename Value>
 class SplayTree {
@@ -31,55 +38,55 @@ private:
     }
 
     /**
-     * @brief splay the node to the root node with the value key
+     * @brief splay the node to the root node with the value key, top-down (Sleator & Tarjan, 1985).
+     * The path is cut into a left tree (keys < key) and a right tree (keys > key) while going down,
+     * so there is no recursion and no stack however deep the tree is.
+     * If key is not in the tree, the last node on the search path becomes the root.
      * 
      * @param node the original root node
      * @param key the value to be splayed to the root node
      * @return Node* 
      */
     Node *splay(Node *node, Key key) {
-        if (!node || node->key == key) {
+        if (!node) {
             return node;
         }
 
-        // Key lies in the left subtree
-        if (key < node->key) {
-            if (!node->left) return node;
-
-            // Zig-Zig (Left Left)
-            if (key < node->left->key) {
-                node->left->left = splay(node->left->left, key);
-                node = rotateRight(node);
-            }
-            // Zig-Zag (Left Right)
-            else if (key > node->left->key) {
-                node->left->right = splay(node->left->right, key);
-                if (node->left->right) {
-                    node->left = rotateLeft(node->left);
+        Node *left_tree = nullptr, *right_tree = nullptr;
+        Node **left_hook = &left_tree;  // where the next node smaller than key is hung
+        Node **right_hook = &right_tree;// where the next node larger than key is hung
+        while (node->key != key) {
+            if (key < node->key) {
+                if (!node->left) break;
+                // Zig-Zig (Left Left)
+                if (key < node->left->key) {
+                    node = rotateRight(node);
+                    if (!node->left) break;
                 }
-            }
-
-            return node->left ? rotateRight(node) : node;
-        }
-        // Key lies in the right subtree
-        else {
-            if (!node->right) return node;
-
-            // Zag-Zig (Right Left)
-            if (key < node->right->key) {
-                node->right->left = splay(node->right->left, key);
-                if (node->right->left) {
-                    node->right = rotateRight(node->right);
+                // link right
+                *right_hook = node;
+                right_hook = &node->left;
+                node = node->left;
+            } else {
+                if (!node->right) break;
+                // Zag-Zag (Right Right)
+                if (key > node->right->key) {
+                    node = rotateLeft(node);
+                    if (!node->right) break;
                 }
+                // link left
+                *left_hook = node;
+                left_hook = &node->right;
+                node = node->right;
             }
-            // Zag-Zag (Right Right)
-            else if (key > node->right->key) {
-                node->right->right = splay(node->right->right, key);
-                node = rotateLeft(node);
-            }
-
-            return node->right ? rotateLeft(node) : node;
         }
+
+        // assemble
+        *left_hook = node->left;
+        *right_hook = node->right;
+        node->left = left_tree;
+        node->right = right_tree;
+        return node;
     }
 
     // Helper function to delete a node
@@ -108,6 +115,22 @@ private:
 public:
     SplayTree() : root(nullptr) {}
 
+    ~SplayTree() {
+        // rotate the left children up so that the nodes are freed without recursion
+        while (root) {
+            if (root->left) {
+                root = rotateRight(root);
+            } else {
+                Node *old = root;
+                root = root->right;
+                delete old;
+            }
+        }
+    }
+
+    SplayTree(const SplayTree &) = delete;
+    SplayTree &operator=(const SplayTree &) = delete;
+
     // Insert a key-value pair
     void insert(Key key, Value value) {
         if (!root) {
@@ -159,7 +182,29 @@ public:
         std::cout << std::endl;
     }
 
+    // Height of the tree (the number of nodes on the longest path)
+    int height() const {
+        return heightHelper(root);
+    }
+
 private:
+    // level by level, the degenerate trees of sequential access are too deep for recursion
+    int heightHelper(Node *node) const {
+        int h = 0;
+        std::vector<Node *> level, next;
+        if (node) level.push_back(node);
+        while (!level.empty()) {
+            ++h;
+            next.clear();
+            for (Node *t : level) {
+                if (t->left) next.push_back(t->left);
+                if (t->right) next.push_back(t->right);
+            }
+            level.swap(next);
+        }
+        return h;
+    }
+
     void printHelper(Node *node) {
         if (!node) return;
         printHelper(node->left);
@@ -168,6 +213,313 @@ private:
     }
 };
 
+/**
+ * @brief Splay tree with implicit keys: the key of a node is its position, which is the size
+ * of everything on its left, so the tree is an editable sequence rather than a map.
+ * Every node keeps its subtree size, and a lazy reverse flag which is pushed down when a
+ * node is passed. Everything is built on a top-down splay by position, and split / join,
+ * so all operations are amortized O(log n) and none of them recurses.
+ * 
+ * @tparam T the element type
+ */
+template<typename T>
+class SplaySequence {
+private:
+    struct Node {
+        T value;
+        size_t size;
+        bool reversed;// the children of every node in this subtree are to be swapped
+        Node *left;
+        Node *right;
+
+        explicit Node(const T &v) : value(v), size(1), reversed(false), left(nullptr), right(nullptr) {}
+    };
+
+    Node *root;
+
+    static size_t sizeOf(Node *node) {
+        return node ? node->size : 0;
+    }
+
+    static void update(Node *node) {
+        node->size = sizeOf(node->left) + sizeOf(node->right) + 1;
+    }
+
+    static void pushDown(Node *node) {
+        if (node->reversed) {
+            std::swap(node->left, node->right);
+            if (node->left) node->left->reversed = !node->left->reversed;
+            if (node->right) node->right->reversed = !node->right->reversed;
+            node->reversed = false;
+        }
+    }
+
+    /**
+     * @brief top-down splay of the node at position pos (0-based, pos < sizeOf(node)).
+     * Only the sizes of the nodes which are linked into the left and right trees go stale
+     * while going down; they are fixed by walking the two spines afterwards.
+     * 
+     * @param node the original root node
+     * @param pos the position to be splayed to the root
+     * @return Node* the new root
+     */
+    static Node *splay(Node *node, size_t pos) {
+        Node *left_tree = nullptr, *right_tree = nullptr;
+        Node **left_hook = &left_tree, **right_hook = &right_tree;
+        size_t left_size = 0, right_size = 0;// sizes of the left and right trees built so far
+
+        while (true) {
+            pushDown(node);
+            size_t left_of_node = sizeOf(node->left);
+            if (pos < left_of_node) {
+                Node *child = node->left;
+                pushDown(child);
+                // Zig-Zig (Left Left)
+                if (pos < sizeOf(child->left)) {
+                    node->left = child->right;
+                    child->right = node;
+                    update(node);
+                    node = child;
+                }
+                // link right
+                *right_hook = node;
+                right_hook = &node->left;
+                right_size += sizeOf(node->right) + 1;
+                node = node->left;
+            } else if (pos > left_of_node) {
+                Node *child = node->right;
+                pushDown(child);
+                // Zag-Zag (Right Right)
+                if (pos - left_of_node - 1 > sizeOf(child->left)) {
+                    node->right = child->left;
+                    child->left = node;
+                    update(node);
+                    node = child;
+                }
+                // link left
+                pos -= sizeOf(node->left) + 1;
+                *left_hook = node;
+                left_hook = &node->right;
+                left_size += sizeOf(node->left) + 1;
+                node = node->right;
+            } else {
+                break;
+            }
+        }
+
+        left_size += sizeOf(node->left);
+        right_size += sizeOf(node->right);
+        *left_hook = nullptr;
+        *right_hook = nullptr;
+        // the right spine of the left tree and the left spine of the right tree
+        for (Node *t = left_tree; t; t = t->right) {
+            t->size = left_size;
+            left_size -= sizeOf(t->left) + 1;
+        }
+        for (Node *t = right_tree; t; t = t->left) {
+            t->size = right_size;
+            right_size -= sizeOf(t->right) + 1;
+        }
+
+        // assemble
+        *left_hook = node->left;
+        *right_hook = node->right;
+        node->left = left_tree;
+        node->right = right_tree;
+        update(node);
+        return node;
+    }
+
+    explicit SplaySequence(Node *root_) : root(root_) {}
+
+    void checkRange(size_t l, size_t r) const {
+        if (l > r || r > size()) {
+            throw std::out_of_range("SplaySequence: invalid range");
+        }
+    }
+
+public:
+    SplaySequence() : root(nullptr) {}
+
+    ~SplaySequence() {
+        clear();
+    }
+
+    SplaySequence(const SplaySequence &) = delete;
+    SplaySequence &operator=(const SplaySequence &) = delete;
+
+    SplaySequence(SplaySequence &&other) noexcept : root(other.root) {
+        other.root = nullptr;
+    }
+
+    SplaySequence &operator=(SplaySequence &&other) noexcept {
+        if (this != &other) {
+            clear();
+            root = other.root;
+            other.root = nullptr;
+        }
+        return *this;
+    }
+
+    size_t size() const {
+        return sizeOf(root);
+    }
+
+    bool empty() const {
+        return root == nullptr;
+    }
+
+    void clear() {
+        // the same rotations as ~SplayTree, the reverse flags do not matter here
+        while (root) {
+            if (root->left) {
+                Node *child = root->left;
+                root->left = child->right;
+                child->right = root;
+                root = child;
+            } else {
+                Node *old = root;
+                root = root->right;
+                delete old;
+            }
+        }
+    }
+
+    /**
+     * @brief The element at position pos, which is splayed to the root
+     */
+    T &operator[](size_t pos) {
+        if (pos >= size()) {
+            throw std::out_of_range("SplaySequence: index out of range");
+        }
+        root = splay(root, pos);
+        return root->value;
+    }
+
+    /**
+     * @brief Cut the sequence before position k: this keeps [0, k), the returned one holds [k, size())
+     */
+    SplaySequence split(size_t k) {
+        checkRange(k, k);
+        if (k == size()) {
+            return SplaySequence();
+        }
+        root = splay(root, k);
+        Node *right = root;
+        root = right->left;
+        right->left = nullptr;
+        update(right);
+        return SplaySequence(right);
+    }
+
+    /**
+     * @brief Append all elements of other to this sequence, other becomes empty
+     */
+    void join(SplaySequence &other) {
+        if (this == &other || !other.root) {
+            return;
+        }
+        if (!root) {
+            std::swap(root, other.root);
+            return;
+        }
+        // the last element has no right child once it is the root
+        root = splay(root, size() - 1);
+        root->right = other.root;
+        other.root = nullptr;
+        update(root);
+    }
+
+    void join(SplaySequence &&other) {
+        join(other);
+    }
+
+    /**
+     * @brief Insert x before position pos, pos == size() appends
+     */
+    void insert_at(size_t pos, const T &x) {
+        checkRange(pos, pos);
+        Node *node = new Node(x);
+        if (pos == size()) {
+            node->left = root;
+        } else {
+            root = splay(root, pos);
+            node->left = root->left;
+            root->left = nullptr;
+            update(root);
+            node->right = root;
+        }
+        update(node);
+        root = node;
+    }
+
+    void push_back(const T &x) {
+        insert_at(size(), x);
+    }
+
+    /**
+     * @brief Remove the elements in [l, r)
+     */
+    void erase_range(size_t l, size_t r) {
+        checkRange(l, r);
+        SplaySequence middle = split(l);
+        SplaySequence tail = middle.split(r - l);
+        join(tail);
+    }
+
+    /**
+     * @brief Reverse the elements in [l, r), O(1) after the two splits thanks to the lazy flag
+     */
+    void reverse(size_t l, size_t r) {
+        checkRange(l, r);
+        SplaySequence middle = split(l);
+        SplaySequence tail = middle.split(r - l);
+        if (middle.root) {
+            middle.root->reversed = !middle.root->reversed;
+        }
+        join(middle);
+        join(tail);
+    }
+
+    /**
+     * @brief Visit the elements in order, without recursion
+     */
+    template<typename Visitor>
+    void forEach(Visitor visit) {
+        std::vector<Node *> stack;
+        Node *t = root;
+        while (t || !stack.empty()) {
+            while (t) {
+                pushDown(t);
+                stack.push_back(t);
+                t = t->left;
+            }
+            t = stack.back();
+            stack.pop_back();
+            visit(t->value);
+            t = t->right;
+        }
+    }
+
+    // Height of the tree (the number of nodes on the longest path)
+    int height() const {
+        int h = 0;
+        std::vector<Node *> level, next;
+        if (root) level.push_back(root);
+        while (!level.empty()) {
+            ++h;
+            next.clear();
+            for (Node *t : level) {
+                if (t->left) next.push_back(t->left);
+                if (t->right) next.push_back(t->right);
+            }
+            level.swap(next);
+        }
+        return h;
+    }
+};
+
+#ifndef BENCHMARK_NO_MAIN
 int main() {
     SplayTree<int, std::string> tree;
 
@@ -232,5 +584,105 @@ int main() {
     tree.insert(50, "Fifty");
     tree.print();
 
+    // Sequential access builds a path, which the recursive splay could not survive
+    std::cout << "\nSequential insertion of 1000000 keys:" << std::endl;
+    SplayTree<int, int> deep;
+    for (int i = 0; i < 1000000; ++i) {
+        deep.insert(i, i);
+    }
+    std::cout << "Height: " << deep.height() << ", find(0): " << (deep.find(0) ? "found" : "not found")
+              << ", height after: " << deep.height() << std::endl;
+
+    std::cout << "\n--- Implicit-key SplaySequence ---" << std::endl;
+    SplaySequence<std::string> playlist;
+    for (std::string song : {"a", "b", "c", "d", "e", "f"}) {
+        playlist.push_back(song);
+    }
+    playlist.insert_at(2, "x");// a b x c d e f
+    playlist.reverse(1, 5);    // a d c x b e f
+    playlist.erase_range(4, 6);// a d c x f
+    SplaySequence<std::string> tail = playlist.split(3);
+    tail.join(playlist);// x f a d c
+    tail.forEach([](const std::string &song) { std::cout << song << " "; });
+    std::cout << "(Expected: x f a d c)" << std::endl;
+
+    // random edits against std::vector
+    std::mt19937 gen(2025);
+    SplaySequence<int> seq;
+    std::vector<int> ref;
+    bool pass = true;
+    for (int i = 0; i < 20000 && pass; ++i) {
+        size_t n = ref.size();
+        int op = gen() % 5;
+        if (op < 2 || n == 0) {
+            size_t pos = gen() % (n + 1);
+            seq.insert_at(pos, i);
+            ref.insert(ref.begin() + pos, i);
+        } else {
+            size_t l = gen() % n, r = l + gen() % (n - l + 1);
+            if (op == 2) {
+                seq.erase_range(l, r);
+                ref.erase(ref.begin() + l, ref.begin() + r);
+            } else if (op == 3) {
+                seq.reverse(l, r);
+                std::reverse(ref.begin() + l, ref.begin() + r);
+            } else if (seq[l] != ref[l]) {
+                pass = false;
+            }
+        }
+        if (i % 500 == 0) {
+            std::vector<int> all;
+            seq.forEach([&all](int x) { all.push_back(x); });
+            pass = pass && all == ref;
+        }
+    }
+    std::cout << "Random edits: " << (pass && seq.size() == ref.size() ? "PASS" : "FAIL") << std::endl;
+
+    // an editable sequence of millions of elements: random inserts, deletes and reversals
+    const size_t n = 2000000, edits = 200000, vector_edits = 2000;
+    std::cout << "\n--- Benchmark: " << edits << " random edits on a sequence of " << n << " elements ---" << std::endl;
+    auto randomEdits = [&gen](auto &container, size_t count, auto insert, auto erase, auto reverse) {
+        for (size_t i = 0; i < count; ++i) {
+            size_t size = container.size();
+            size_t pos = gen() % size, len = std::min<size_t>(gen() % 100, size - pos);
+            switch (i % 3) {
+                case 0: insert(pos, int(i)); break;
+                case 1: erase(pos, pos + len / 2); break;
+                default: reverse(pos, pos + len); break;
+            }
+        }
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    SplaySequence<int> big;
+    for (size_t i = 0; i < n; ++i) {
+        big.push_back(int(i));
+    }
+    auto built = std::chrono::high_resolution_clock::now();
+    randomEdits(
+            big, edits, [&big](size_t pos, int x) { big.insert_at(pos, x); },
+            [&big](size_t l, size_t r) { big.erase_range(l, r); },
+            [&big](size_t l, size_t r) { big.reverse(l, r); });
+    auto edited = std::chrono::high_resolution_clock::now();
+
+    std::vector<int> vec(n);
+    for (size_t i = 0; i < n; ++i) {
+        vec[i] = int(i);
+    }
+    auto vector_start = std::chrono::high_resolution_clock::now();
+    randomEdits(
+            vec, vector_edits, [&vec](size_t pos, int x) { vec.insert(vec.begin() + pos, x); },
+            [&vec](size_t l, size_t r) { vec.erase(vec.begin() + l, vec.begin() + r); },
+            [&vec](size_t l, size_t r) { std::reverse(vec.begin() + l, vec.begin() + r); });
+    auto vector_end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::micro> build_time = built - start, edit_time = edited - built,
+                                                vector_time = vector_end - vector_start;
+    std::cout << "SplaySequence: build " << build_time.count() / 1000 << " ms, "
+              << edit_time.count() / edits << " us per edit" << std::endl;
+    std::cout << "std::vector: " << vector_time.count() / vector_edits << " us per edit ("
+              << vector_edits << " edits)" << std::endl;
+
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,415 @@
+/*
+Benchmark harness for the ordered containers: BST, AVLTree (iterative and recursive), RBT, SplayTree, Treap, BitmapTrie, sjtu::map and std::map.
+Every container is driven through the same adapter, in a forked child process so that
+the peak RSS belongs to one container only.
+
+usage: tree_benchmark [--max-size N] [--sizes 1000,10000,...] [--workloads random,sorted,zipf]
+                      [--trees BST,AVLTree,...] [--csv file] [--json file]
+
+The sizes go from 10^3 by factors of 10 up to --max-size, which is 10^6 by default.
+Pass --max-size 100000000 for the full range up to 10^8: at 10^6 one random workload over all the
+trees takes about 30 s and a tree peaks at about 60 MB (sjtu::map at about 110 MB), so 10^8 needs
+some 6-11 GB per tree process and hours of runtime.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define BENCHMARK_NO_MAIN
+#include "AVLTree.cpp"
+#include "BitmapTrie.cpp"
+#include "BST.cpp"
+#include "RBT.cpp"
+#include "map.hpp"
+#include "splay_tree.cpp"
+#include "Treap.cpp"
+#undef BENCHMARK_NO_MAIN
+
+// --- Adapter interface ---
+
+class orderedAdapter {
+public:
+    virtual ~orderedAdapter() {}
+    virtual void insert(int key) = 0;
+    virtual bool find(int key) = 0;
+    virtual void remove(int key) = 0;
+    // height of the tree, -1 if the container does not expose it
+    virtual long long height() const = 0;
+    // recursive implementations overflow the stack on degenerate trees,
+    // the sorted workload is skipped above this size
+    virtual size_t maxSortedSize() const { return SIZE_MAX; }
+};
+
+// BST, AVLTree, RBT, Treap and BitmapTrie share the dynamicSearchTable interface
+template<class Tree>
+class searchTableAdapter : public orderedAdapter {
+private:
+    Tree tree;
+    size_t max_sorted;
+
+public:
+    explicit searchTableAdapter(size_t max_sorted_ = SIZE_MAX) : max_sorted(max_sorted_) {}
+    void insert(int key) { tree.insert(set<int, int>{key, key}); }
+    bool find(int key) { return tree.find(key) != nullptr; }
+    void remove(int key) { tree.remove(key); }
+    long long height() const { return tree.height(); }
+    size_t maxSortedSize() const { return max_sorted; }
+};
+
+// the recursive AVLTree insert / remove, the baseline of the iterative ones
+class recursiveAVLAdapter : public orderedAdapter {
+private:
+    AVLTree<int, int> tree;
+
+public:
+    void insert(int key) { tree.insertRecursive(set<int, int>{key, key}); }
+    bool find(int key) { return tree.find(key) != nullptr; }
+    void remove(int key) { tree.removeRecursive(key); }
+    long long height() const { return tree.height(); }
+};
+
+class splayAdapter : public orderedAdapter {
+private:
+    SplayTree<int, int> tree;
+
+public:
+    void insert(int key) { tree.insert(key, key); }
+    bool find(int key) { return tree.find(key) != nullptr; }
+    void remove(int key) { tree.remove(key); }
+    long long height() const { return tree.height(); }
+};
+
+class sjtuMapAdapter : public orderedAdapter {
+private:
+    sjtu::map<int, int> tree;
+
+public:
+    void insert(int key) { tree.insert(sjtu::pair<const int, int>(key, key)); }
+    bool find(int key) { return tree.find(key) != tree.end(); }
+    void remove(int key) {
+        auto it = tree.find(key);
+        if (it != tree.end()) tree.erase(it);
+    }
+    long long height() const { return tree.height(); }
+};
+
+class stdMapAdapter : public orderedAdapter {
+private:
+    std::map<int, int> tree;
+
+public:
+    void insert(int key) { tree.emplace(key, key); }
+    bool find(int key) { return tree.find(key) != tree.end(); }
+    void remove(int key) { tree.erase(key); }
+    long long height() const { return -1; }
+};
+
+const char *tree_names[] = {"BST", "AVLTree", "AVLTree-rec", "RBT", "SplayTree", "Treap", "BitmapTrie", "sjtu::map", "std::map"};
+const size_t tree_num = sizeof(tree_names) / sizeof(tree_names[0]);
+
+std::unique_ptr<orderedAdapter> makeAdapter(const std::string &name) {
+    if (name == "BST") return std::unique_ptr<orderedAdapter>(new searchTableAdapter<BST<int, int>>(10000));
+    if (name == "AVLTree") return std::unique_ptr<orderedAdapter>(new searchTableAdapter<AVLTree<int, int>>());
+    if (name == "AVLTree-rec") return std::unique_ptr<orderedAdapter>(new recursiveAVLAdapter());
+    if (name == "RBT") return std::unique_ptr<orderedAdapter>(new searchTableAdapter<RBT<int, int>>());
+    if (name == "SplayTree") return std::unique_ptr<orderedAdapter>(new splayAdapter());
+    if (name == "Treap") return std::unique_ptr<orderedAdapter>(new searchTableAdapter<Treap<int, int>>());
+    if (name == "BitmapTrie") return std::unique_ptr<orderedAdapter>(new searchTableAdapter<BitmapTrie<int, int>>());
+    if (name == "sjtu::map") return std::unique_ptr<orderedAdapter>(new sjtuMapAdapter());
+    if (name == "std::map") return std::unique_ptr<orderedAdapter>(new stdMapAdapter());
+    return nullptr;
+}
+
+// --- Workloads ---
+
+enum opType { FIND,
+              INSERT,
+              REMOVE };
+
+struct operation {
+    int key;
+    int type;
+};
+
+struct workload {
+    std::vector<int> build;     // keys inserted before the measured phase
+    std::vector<operation> ops; // the measured mix: 50% find, 25% insert, 25% remove
+};
+
+/**
+ * @brief Zipf distributed ranks in [0, n) (Gray et al., "Quickly generating billion-record
+ * synthetic databases"), O(n) setup, O(1) memory
+ */
+class zipfGenerator {
+private:
+    uint64_t n;
+    double theta, alpha, zetan, eta;
+
+public:
+    zipfGenerator(uint64_t n_, double theta_ = 0.99) : n(n_), theta(theta_) {
+        zetan = 0;
+        for (uint64_t i = 1; i <= n; ++i) zetan += 1.0 / std::pow(double(i), theta);
+        double zeta2 = 1 + 1.0 / std::pow(2.0, theta);
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta2 / zetan);
+    }
+
+    template<class RNG>
+    uint64_t operator()(RNG &gen) {
+        double u = std::uniform_real_distribution<double>(0, 1)(gen);
+        double uz = u * zetan;
+        if (uz < 1) return 0;
+        if (uz < 1 + std::pow(0.5, theta)) return 1;
+        return std::min<uint64_t>(n - 1, uint64_t(n * std::pow(eta * u - eta + 1, alpha)));
+    }
+};
+
+/**
+ * @brief n keys are built from the even numbers in [0, 2n), so half of the random finds miss
+ */
+workload makeWorkload(const std::string &name, size_t n, uint32_t seed) {
+    std::mt19937_64 gen(seed);
+    workload w;
+    w.build.resize(n);
+    for (size_t i = 0; i < n; ++i) w.build[i] = int(2 * i);
+    if (name != "sorted") std::shuffle(w.build.begin(), w.build.end(), gen);
+
+    w.ops.resize(n);
+    if (name == "sorted") {
+        // ascending scans over the keys: find every 2nd key, remove every 4th key, then insert them back
+        for (size_t i = 0; i < n; ++i) {
+            if (i < n / 2) {
+                w.ops[i] = operation{int(2 * (2 * i)), FIND};
+            } else if (i < 3 * n / 4) {
+                w.ops[i] = operation{int(2 * (4 * (i - n / 2))), REMOVE};
+            } else {
+                w.ops[i] = operation{int(2 * (4 * (i - 3 * n / 4))), INSERT};
+            }
+        }
+    } else if (name == "zipf") {
+        zipfGenerator zipf(2 * n);
+        for (size_t i = 0; i < n; ++i) {
+            // scatter the hot ranks over the key space
+            uint64_t key = (zipf(gen) * 0x9E3779B97F4A7C15ull) % (2 * n);
+            uint64_t r = gen() % 4;
+            w.ops[i] = operation{int(key), r < 2 ? FIND : (r == 2 ? INSERT : REMOVE)};
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t r = gen() % 4;
+            w.ops[i] = operation{int(gen() % (2 * n)), r < 2 ? FIND : (r == 2 ? INSERT : REMOVE)};
+        }
+    }
+    return w;
+}
+
+// --- Measurement ---
+
+struct result {
+    double build_mops;  // inserts per microsecond (million per second)
+    double mixed_mops;
+    double p50_ns, p99_ns, p999_ns;
+    long long height;
+    long long peak_rss_kb;
+    long long hits;     // number of successful finds, identical for all containers
+};
+
+long long peakRSS() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::stoll(line.substr(6));
+        }
+    }
+    return -1;
+}
+
+result run(const std::string &tree, const workload &w) {
+    typedef std::chrono::steady_clock clock;
+    result r{};
+    std::unique_ptr<orderedAdapter> c = makeAdapter(tree);
+
+    auto start = clock::now();
+    for (int key : w.build) c->insert(key);
+    auto end = clock::now();
+    r.build_mops = w.build.size() / std::chrono::duration<double, std::micro>(end - start).count();
+    r.height = c->height();
+
+    // only every stride-th operation is timed, so that the clock does not dominate
+    const size_t stride = 8;
+    std::vector<uint32_t> latency;
+    latency.reserve(std::min<size_t>(w.ops.size() / stride + 1, 1 << 20));
+    size_t sample_gap = std::max<size_t>(1, w.ops.size() / stride / (1 << 20));
+
+    long long hits = 0;
+    start = clock::now();
+    for (size_t i = 0; i < w.ops.size(); ++i) {
+        const operation &op = w.ops[i];
+        bool timed = i % (stride * sample_gap) == 0;
+        clock::time_point t0;
+        if (timed) t0 = clock::now();
+        switch (op.type) {
+            case FIND:
+                hits += c->find(op.key);
+                break;
+            case INSERT:
+                c->insert(op.key);
+                break;
+            default:
+                c->remove(op.key);
+        }
+        if (timed) latency.push_back(uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0).count()));
+    }
+    end = clock::now();
+    r.mixed_mops = w.ops.size() / std::chrono::duration<double, std::micro>(end - start).count();
+    r.hits = hits;
+
+    std::sort(latency.begin(), latency.end());
+    auto percentile = [&](double p) -> double {
+        return latency.empty() ? 0 : latency[size_t(p * (latency.size() - 1))];
+    };
+    r.p50_ns = percentile(0.5);
+    r.p99_ns = percentile(0.99);
+    r.p999_ns = percentile(0.999);
+    r.peak_rss_kb = peakRSS();
+    return r;
+}
+
+/**
+ * @brief run in a child process, the result comes back through a pipe
+ */
+bool runIsolated(const std::string &tree, const workload &w, result &r) {
+    int fd[2];
+    if (pipe(fd) != 0) return false;
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fd[0]);
+        result child = run(tree, w);
+        ssize_t written = write(fd[1], &child, sizeof(child));
+        _exit(written == sizeof(child) ? 0 : 1);
+    }
+    close(fd[1]);
+    ssize_t got = read(fd[0], &r, sizeof(r));
+    close(fd[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return got == sizeof(r) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+std::vector<std::string> split(const std::string &s) {
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) parts.push_back(item);
+    return parts;
+}
+
+int main(int argc, char *argv[]) {
+    // 10^8 is reachable with --max-size, see the usage above for why it is not the default
+    size_t max_size = 1000000;
+    std::vector<size_t> sizes;
+    std::vector<std::string> workloads = {"random", "sorted", "zipf"};
+    std::vector<std::string> trees(tree_names, tree_names + tree_num);
+    std::string csv_path, json_path;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << arg << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--max-size") {
+            max_size = std::stoull(value);
+        } else if (arg == "--sizes") {
+            for (auto &s : split(value)) sizes.push_back(std::stoull(s));
+        } else if (arg == "--workloads") {
+            workloads = split(value);
+        } else if (arg == "--trees") {
+            trees = split(value);
+        } else if (arg == "--csv") {
+            csv_path = value;
+        } else if (arg == "--json") {
+            json_path = value;
+        } else {
+            std::cerr << "unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (sizes.empty()) {
+        for (size_t n = 1000; n <= max_size; n *= 10) sizes.push_back(n);
+    }
+    for (auto &tree : trees) {
+        if (makeAdapter(tree) == nullptr) {
+            std::cerr << "unknown tree " << tree << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream csv, json;
+    if (!csv_path.empty()) {
+        csv.open(csv_path);
+        csv << "tree,workload,size,build_mops,mixed_mops,p50_ns,p99_ns,p999_ns,height,peak_rss_kb,hits\n";
+    }
+    if (!json_path.empty()) {
+        json.open(json_path);
+        json << "[";
+    }
+    bool first_json = true;
+
+    std::printf("%-11s %-7s %10s %10s %10s %8s %8s %9s %7s %12s %10s\n", "tree", "load", "size",
+                "build M/s", "mixed M/s", "p50 ns", "p99 ns", "p99.9 ns", "height", "peak RSS KB", "hits");
+    for (size_t n : sizes) {
+        for (auto &load : workloads) {
+            workload w = makeWorkload(load, n, 2025);
+            long long expected_hits = -1;
+            for (auto &tree : trees) {
+                if (load == "sorted" && n > makeAdapter(tree)->maxSortedSize()) {
+                    std::printf("%-11s %-7s %10zu   skipped (recursion depth on a degenerate tree)\n", tree.c_str(), load.c_str(), n);
+                    continue;
+                }
+                result r;
+                if (!runIsolated(tree, w, r)) {
+                    std::printf("%-11s %-7s %10zu   FAILED (crashed)\n", tree.c_str(), load.c_str(), n);
+                    continue;
+                }
+                if (expected_hits < 0) expected_hits = r.hits;
+                std::printf("%-11s %-7s %10zu %10.3f %10.3f %8.0f %8.0f %9.0f %7lld %12lld %10lld%s\n", tree.c_str(), load.c_str(), n,
+                            r.build_mops, r.mixed_mops, r.p50_ns, r.p99_ns, r.p999_ns, r.height, r.peak_rss_kb, r.hits,
+                            r.hits == expected_hits ? "" : "  MISMATCH");
+                std::fflush(stdout);
+
+                if (csv.is_open()) {
+                    csv << tree << ',' << load << ',' << n << ',' << r.build_mops << ',' << r.mixed_mops << ','
+                        << r.p50_ns << ',' << r.p99_ns << ',' << r.p999_ns << ',' << r.height << ','
+                        << r.peak_rss_kb << ',' << r.hits << '\n';
+                }
+                if (json.is_open()) {
+                    json << (first_json ? "\n" : ",\n") << "  {\"tree\": \"" << tree << "\", \"workload\": \"" << load
+                         << "\", \"size\": " << n << ", \"build_mops\": " << r.build_mops << ", \"mixed_mops\": " << r.mixed_mops
+                         << ", \"p50_ns\": " << r.p50_ns << ", \"p99_ns\": " << r.p99_ns << ", \"p999_ns\": " << r.p999_ns
+                         << ", \"height\": " << r.height << ", \"peak_rss_kb\": " << r.peak_rss_kb << ", \"hits\": " << r.hits << "}";
+                    first_json = false;
+                }
+            }
+        }
+    }
+    if (json.is_open()) json << "\n]\n";
+    return 0;
+}
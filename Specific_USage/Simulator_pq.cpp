@@ -8,13 +8,230 @@
  * Do you code and make progress today?
  * Copyright (c) 2025 by Xiyuan Yang, All Rights Reserved. 
  */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
 #include <cstdlib>
 #include <iostream>
 #include <queue>
 #include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
+/**
+ * @brief Calendar queue (R. Brown, 1988) for discrete event simulation.
+ * Events are hashed by time into a circular array of buckets ("days"), each bucket
+ * keeps a sorted linked list. Dequeue scans forward from the last dequeued bucket,
+ * so both enQueue and deQueue are O(1) amortized as long as the bucket width
+ * matches the average event separation, which is re-estimated on every resize.
+ * Events with the same time are dequeued in FIFO order.
+ * @tparam T The event type, must provide a `size_t time` member.
+ */
+template<class T>
+class calendarQueue {
+private:
+    struct Node {
+        T data;
+        Node *next;
+    };
+
+    Node **bucket;
+    size_t bucket_num;  // always a power of 2
+    size_t width;       // time span covered by one bucket
+    size_t current_size;
+    size_t last_bucket; // bucket of the last dequeued event
+    size_t bucket_top;  // (exclusive) upper time bound of last_bucket in the current "year"
+    size_t last_time;   // time of the last dequeued event
+    Node *free_list;    // recycled nodes, avoid calling new for every event
+
+    static const size_t min_bucket_num = 2;
+
+    size_t index(size_t time) const {
+        return (time / width) & (bucket_num - 1);
+    }
+
+    Node *getNode(const T &x) {
+        Node *p;
+        if (free_list != nullptr) {
+            p = free_list;
+            free_list = free_list->next;
+            p->data = x;
+        } else {
+            p = new Node{x, nullptr};
+        }
+        return p;
+    }
+
+    void putNode(Node *p) {
+        p->next = free_list;
+        free_list = p;
+    }
+
+    /**
+     * @brief insert the node into its bucket, after all the events with the same time
+     */
+    void link(Node *p) {
+        Node **pos = &bucket[index(p->data.time)];
+        while (*pos != nullptr && (*pos)->data.time <= p->data.time) {
+            pos = &(*pos)->next;
+        }
+        p->next = *pos;
+        *pos = p;
+    }
+
+    void setCursor(size_t time) {
+        last_time = time;
+        last_bucket = index(time);
+        bucket_top = (time / width + 1) * width;
+    }
+
+    /**
+     * @brief rebuild the calendar with new_num buckets and a re-estimated bucket width
+     */
+    void resize(size_t new_num) {
+        Node *all = nullptr;
+        std::vector<size_t> times;
+        times.reserve(current_size);
+        for (size_t i = 0; i < bucket_num; ++i) {
+            Node *p = bucket[i];
+            while (p != nullptr) {
+                Node *q = p->next;
+                times.push_back(p->data.time);
+                p->next = all;
+                all = p;
+                p = q;
+            }
+        }
+
+        // the width is three times the average separation of the earliest events
+        size_t sample = std::min<size_t>(times.size(), 32);
+        if (sample >= 2) {
+            std::partial_sort(times.begin(), times.begin() + sample, times.end());
+            size_t separation = (times[sample - 1] - times[0]) / (sample - 1);
+            width = std::max<size_t>(1, 3 * separation);
+        }
+
+        delete[] bucket;
+        bucket_num = new_num;
+        bucket = new Node *[bucket_num]();
+        while (all != nullptr) {
+            Node *q = all->next;
+            link(all);
+            all = q;
+        }
+        setCursor(last_time);
+    }
+
+public:
+    explicit calendarQueue(size_t width_ = 1)
+        : bucket_num(min_bucket_num), width(width_ == 0 ? 1 : width_), current_size(0), free_list(nullptr) {
+        bucket = new Node *[bucket_num]();
+        setCursor(0);
+    }
+
+    calendarQueue(const calendarQueue &) = delete;
+    calendarQueue &operator=(const calendarQueue &) = delete;
+
+    ~calendarQueue() {
+        for (size_t i = 0; i < bucket_num; ++i) {
+            while (bucket[i] != nullptr) {
+                Node *q = bucket[i]->next;
+                delete bucket[i];
+                bucket[i] = q;
+            }
+        }
+        while (free_list != nullptr) {
+            Node *q = free_list->next;
+            delete free_list;
+            free_list = q;
+        }
+        delete[] bucket;
+    }
+
+    bool empty() const {
+        return current_size == 0;
+    }
+
+    size_t size() const {
+        return current_size;
+    }
+
+    void enQueue(const T &x) {
+        link(getNode(x));
+        ++current_size;
+        if (x.time < last_time) {
+            // an event in the "past", move the cursor back to it
+            setCursor(x.time);
+        }
+        if (current_size > 2 * bucket_num) {
+            resize(bucket_num * 2);
+        }
+    }
+
+    T deQueue() {
+        if (empty()) {
+            throw std::underflow_error("Calendar queue is empty");
+        }
+
+        Node *p = nullptr;
+        size_t i = last_bucket, top = bucket_top;
+        for (size_t n = 0; n < bucket_num; ++n) {
+            if (bucket[i] != nullptr && bucket[i]->data.time < top) {
+                p = bucket[i];
+                break;
+            }
+            i = (i + 1) & (bucket_num - 1);
+            top += width;
+        }
+
+        if (p == nullptr) {
+            // a whole year is empty, search the minimum directly
+            for (size_t j = 0; j < bucket_num; ++j) {
+                if (bucket[j] != nullptr && (p == nullptr || bucket[j]->data.time < p->data.time)) {
+                    p = bucket[j];
+                }
+            }
+            i = index(p->data.time);
+        }
+
+        bucket[i] = p->next;
+        --current_size;
+        setCursor(p->data.time);
+
+        T min_item = p->data;
+        putNode(p);
+        if (bucket_num > min_bucket_num && current_size < bucket_num / 2) {
+            resize(bucket_num / 2);
+        }
+        return min_item;
+    }
+};
+
+/**
+ * @brief Parameters of the queueing model, so that the simulator can run without std::cin
+ */
+struct simulatorConfig {
+    std::size_t server_num = 1;
+    std::size_t custom_num = 1000;
+    std::size_t arrival_low = 1;
+    std::size_t arrival_high = 5;
+    std::size_t service_time_low = 1;
+    std::size_t service_time_high = 5;
+};
+
+/**
+ * @brief Statistics of one replication
+ */
+struct replicationResult {
+    double avg_wait_time;
+    std::size_t end_time;                 // time of the last departure
+    std::vector<std::size_t> server_busy_time;// total service time of every server
+};
+
 class simulator {
 private:
     std::size_t server_num;
@@ -26,7 +243,8 @@ private:
 
     struct event {
         size_t time;
-        int type;// 0 for arriving, 1 for leaving
+        int type;     // 0 for arriving, 1 for leaving
+        size_t server;// the server of a leaving customer
         bool operator<(const event &other) const {
             return time > other.time;// 最小堆
         }
@@ -47,14 +265,119 @@ public:
         std::cin >> custom_num;
     }
 
-    double avgWaitTime() {
+    explicit simulator(const simulatorConfig &config)
+        : server_num(config.server_num), custom_num(config.custom_num),
+          arrival_low(config.arrival_low), arrival_high(config.arrival_high),
+          service_time_high(config.service_time_high), service_time_low(config.service_time_low) {}
+
+    simulatorConfig config() const {
+        simulatorConfig config;
+        config.server_num = server_num;
+        config.custom_num = custom_num;
+        config.arrival_low = arrival_low;
+        config.arrival_high = arrival_high;
+        config.service_time_low = service_time_low;
+        config.service_time_high = service_time_high;
+        return config;
+    }
+
+    /**
+     * @brief Simulate one replication with the calendar queue. Arrivals are generated
+     * lazily: only the next arrival is kept in the event queue, so memory is bounded
+     * by the in-flight events instead of the number of customers.
+     * Arrival intervals and service times are drawn from two separate streams seeded
+     * from seed, so avg_wait_time is identical to avgWaitTimeHeap(seed).
+     * The simulator itself is not modified, replications can run concurrently.
+     *
+     * @param seed
+     * @return replicationResult
+     */
+    replicationResult replicate(unsigned seed) const {
+        replicationResult result{0, 0, std::vector<std::size_t>(server_num, 0)};
+        if (custom_num == 0) {
+            return result;
+        }
+
+        std::size_t total_wait_time = 0;
+
+        calendarQueue<event> eventQueue(std::max<size_t>(1, (arrival_low + arrival_high) / 2));
+        std::queue<event> waitQueue;
+        // idle servers, the number of busy servers is server_num - free_server.size()
+        std::vector<std::size_t> free_server;
+        for (size_t i = server_num; i > 0; --i) {
+            free_server.push_back(i - 1);
+        }
+
+        std::seed_seq seeds{seed};
+        std::mt19937 arrival_rng(seeds), service_rng(seed);
+        std::uniform_int_distribution<size_t> arrival_dist(arrival_low, arrival_high);
+        std::uniform_int_distribution<size_t> service_dist(service_time_low, service_time_high);
+
+        // only the first arrival is scheduled up front
+        std::size_t generated = 1;
+        eventQueue.enQueue(event{arrival_dist(arrival_rng), 0, 0});
+
+        // Simulation
+        while (!eventQueue.empty()) {
+            event current_event = eventQueue.deQueue();
+
+            if (current_event.type == 0) {// Arrival
+                if (generated < custom_num) {
+                    ++generated;
+                    eventQueue.enQueue(event{current_event.time + arrival_dist(arrival_rng), 0, 0});
+                }
+                if (!free_server.empty()) {
+                    size_t server = free_server.back();
+                    free_server.pop_back();
+                    size_t service = service_dist(service_rng);
+                    result.server_busy_time[server] += service;
+                    eventQueue.enQueue(event{current_event.time + service, 1, server});
+                } else {
+                    waitQueue.push(current_event);
+                }
+            } else {// Departure
+                result.end_time = current_event.time;
+                if (!waitQueue.empty()) {
+                    event next_event = waitQueue.front();
+                    waitQueue.pop();
+                    total_wait_time += (current_event.time - next_event.time);
+                    size_t service = service_dist(service_rng);
+                    result.server_busy_time[current_event.server] += service;
+                    eventQueue.enQueue(event{current_event.time + service, 1, current_event.server});
+                } else {
+                    free_server.push_back(current_event.server);
+                }
+            }
+        }
+
+        result.avg_wait_time = static_cast<double>(total_wait_time) / custom_num;
+        return result;
+    }
+
+    double avgWaitTime(unsigned seed = std::random_device{}()) const {
+        return replicate(seed).avg_wait_time;
+    }
+
+    /**
+     * @brief The original simulation: every arrival is prebuilt into a binary heap.
+     * Kept as the reference for avgWaitTime, O(custom_num) memory.
+     *
+     * @param seed
+     * @return double
+     */
+    double avgWaitTimeHeap(unsigned seed = std::random_device{}()) const {
+        if (custom_num == 0) {
+            return 0;
+        }
+
         std::size_t server_busy = 0;
         std::size_t total_wait_time = 0;
 
         std::priority_queue<event> eventQueue;
         std::queue<event> waitQueue;
 
-        std::mt19937 rng(std::random_device{}());
+        std::seed_seq seeds{seed};
+        std::mt19937 arrival_rng(seeds), service_rng(seed);
         std::uniform_int_distribution<size_t> arrival_dist(arrival_low, arrival_high);
         std::uniform_int_distribution<size_t> service_dist(service_time_low, service_time_high);
 
@@ -62,11 +385,11 @@ public:
         std::vector<size_t> arrival_times(custom_num);
         for (size_t i = 0; i < custom_num; ++i) {
             if (i == 0) {
-                arrival_times[i] = arrival_dist(rng);
+                arrival_times[i] = arrival_dist(arrival_rng);
             } else {
-                arrival_times[i] = arrival_times[i - 1] + arrival_dist(rng);
+                arrival_times[i] = arrival_times[i - 1] + arrival_dist(arrival_rng);
             }
-            event arrival_event{arrival_times[i], 0};
+            event arrival_event{arrival_times[i], 0, 0};
             eventQueue.push(arrival_event);
         }
 
@@ -78,7 +401,7 @@ public:
             if (current_event.type == 0) {// Arrival
                 if (server_busy < server_num) {
                     ++server_busy;
-                    event departure_event{current_event.time + service_dist(rng), 1};
+                    event departure_event{current_event.time + service_dist(service_rng), 1, 0};
                     eventQueue.push(departure_event);
                 } else {
                     waitQueue.push(current_event);
@@ -88,7 +411,7 @@ public:
                     event next_event = waitQueue.front();
                     waitQueue.pop();
                     total_wait_time += (current_event.time - next_event.time);
-                    event departure_event{current_event.time + service_dist(rng), 1};
+                    event departure_event{current_event.time + service_dist(service_rng), 1, 0};
                     eventQueue.push(departure_event);
                 } else {
                     --server_busy;
@@ -100,8 +423,171 @@ public:
     }
 };
 
-int main() {
-    simulator sim;
-    std::cout << "Average Wait Time: " << sim.avgWaitTime() << std::endl;
+/**
+ * @brief Aggregated statistics over all the replications
+ */
+struct replicationSummary {
+    std::size_t replications;
+    double mean;    // mean of the average wait time
+    double variance;// sample variance of the average wait time
+    double ci_half; // half width of the 95% confidence interval of the mean
+    double p50, p90, p99;
+    std::vector<double> utilization;// mean utilization of every server
+};
+
+/**
+ * @brief Run independent replications on a pool of threads.
+ * Replication i is seeded from seed_seq{master_seed, i}, so the summary only depends
+ * on the master seed, not on the number of threads or the scheduling order.
+ *
+ * @param sim
+ * @param replications
+ * @param master_seed
+ * @param thread_num 0 for std::thread::hardware_concurrency()
+ * @return replicationSummary
+ */
+replicationSummary runReplications(const simulator &sim, std::size_t replications, unsigned master_seed,
+                                   std::size_t thread_num = 0) {
+    if (thread_num == 0) {
+        thread_num = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+    thread_num = std::min(thread_num, std::max<std::size_t>(1, replications));
+
+    std::size_t server_num = sim.config().server_num;
+    std::vector<double> wait(replications);
+    std::vector<double> utilization(replications * server_num);
+    std::atomic<std::size_t> next{0};
+
+    // every worker takes the next replication index until all are done
+    auto worker = [&]() {
+        std::size_t i;
+        while ((i = next.fetch_add(1)) < replications) {
+            std::seed_seq seeds{master_seed, static_cast<unsigned>(i), static_cast<unsigned>(i >> 32)};
+            unsigned seed;
+            seeds.generate(&seed, &seed + 1);
+
+            replicationResult result = sim.replicate(seed);
+            wait[i] = result.avg_wait_time;
+            for (std::size_t s = 0; s < server_num; ++s) {
+                utilization[i * server_num + s] = result.end_time == 0 ? 0 : static_cast<double>(result.server_busy_time[s]) / result.end_time;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < thread_num; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : pool) {
+        thread.join();
+    }
+
+    replicationSummary summary{replications, 0, 0, 0, 0, 0, 0, std::vector<double>(server_num, 0)};
+    if (replications == 0) {
+        return summary;
+    }
+    for (std::size_t i = 0; i < replications; ++i) {
+        summary.mean += wait[i];
+        for (std::size_t s = 0; s < server_num; ++s) {
+            summary.utilization[s] += utilization[i * server_num + s] / replications;
+        }
+    }
+    summary.mean /= replications;
+    for (std::size_t i = 0; i < replications; ++i) {
+        summary.variance += (wait[i] - summary.mean) * (wait[i] - summary.mean);
+    }
+    summary.variance = replications > 1 ? summary.variance / (replications - 1) : 0;
+    summary.ci_half = 1.96 * std::sqrt(summary.variance / replications);
+
+    std::sort(wait.begin(), wait.end());
+    auto percentile = [&](double p) {
+        return wait[static_cast<std::size_t>(p * (replications - 1) + 0.5)];
+    };
+    summary.p50 = percentile(0.50);
+    summary.p90 = percentile(0.90);
+    summary.p99 = percentile(0.99);
+    return summary;
+}
+
+/**
+ * usage:
+ *   Simulator_pq                      interactive, one replication on the calendar queue
+ *   Simulator_pq --verify             the same, then rerun on the binary heap and compare
+ *   Simulator_pq --servers 3 --arrival 1 5 --service 2 12 --customers 100000
+ *                --replications 1000 --threads 8 --seed 42
+ */
+int main(int argc, char *argv[]) {
+    bool verify = argc == 2 && std::string(argv[1]) == "--verify";
+    if (argc == 1 || verify) {
+        simulator sim;
+        unsigned seed = std::random_device{}();
+
+        auto start = std::chrono::high_resolution_clock::now();
+        double calendar_result = sim.avgWaitTime(seed);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> calendar_time = end - start;
+        std::cout << "Average Wait Time: " << calendar_result << std::endl;
+        std::cout << "Seed " << seed << ", calendar queue: " << calendar_time.count() * 1000 << " ms";
+
+        // the heap holds every arrival at once, so it only runs when asked for
+        if (verify) {
+            start = std::chrono::high_resolution_clock::now();
+            double heap_result = sim.avgWaitTimeHeap(seed);
+            end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> heap_time = end - start;
+            std::cout << ", binary heap: " << heap_time.count() * 1000 << " ms"
+                      << (calendar_result == heap_result ? " (identical)" : " (MISMATCH)");
+        }
+        std::cout << std::endl;
+        return 0;
+    }
+
+    simulatorConfig config;
+    std::size_t replications = 100, thread_num = 0;
+    unsigned master_seed = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::size_t {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            return std::stoull(argv[++i]);
+        };
+        if (arg == "--servers") {
+            config.server_num = value();
+        } else if (arg == "--arrival") {
+            config.arrival_low = value();
+            config.arrival_high = value();
+        } else if (arg == "--service") {
+            config.service_time_low = value();
+            config.service_time_high = value();
+        } else if (arg == "--customers") {
+            config.custom_num = value();
+        } else if (arg == "--replications") {
+            replications = value();
+        } else if (arg == "--threads") {
+            thread_num = value();
+        } else if (arg == "--seed") {
+            master_seed = static_cast<unsigned>(value());
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    simulator sim(config);
+    auto start = std::chrono::high_resolution_clock::now();
+    replicationSummary summary = runReplications(sim, replications, master_seed, thread_num);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+
+    std::cout << "Replications: " << summary.replications << " (" << elapsed.count() * 1000 << " ms)" << std::endl;
+    std::cout << "Average Wait Time: " << summary.mean << " +- " << summary.ci_half << " (95% CI)" << std::endl;
+    std::cout << "Variance: " << summary.variance << std::endl;
+    std::cout << "Percentiles: p50 " << summary.p50 << ", p90 " << summary.p90 << ", p99 " << summary.p99 << std::endl;
+    for (std::size_t s = 0; s < summary.utilization.size(); ++s) {
+        std::cout << "Server " << s << " utilization: " << summary.utilization[s] << std::endl;
+    }
     return 0;
-}
\ No newline at end of file
+}